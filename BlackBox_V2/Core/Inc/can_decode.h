@@ -0,0 +1,32 @@
+/*
+ * can_decode.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_CAN_DECODE_H_
+#define INC_CAN_DECODE_H_
+
+#include "can_ring_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAN_ID_ENGINE_DATA 0x158
+
+#define VEHICLE_STALE_MS 500 // ENGINE_DATA BROADCASTS AT 100 Hz; OLDER THAN THIS IS NO LONGER KNOWN
+
+/* Latest signals decoded from the bus, updated from the main loop as frames are drained */
+typedef struct {
+	uint16_t speed_ckph;	// XMISSION_SPEED, 0.01 KPH
+	uint16_t engine_rpm;
+	uint32_t tick;			// HAL_GetTick() OF THE LAST ENGINE_DATA
+	bool valid;
+} vehicle_state_t;
+
+extern vehicle_state_t vehicle;
+
+void can_decode_frame(const can_frame_t *frame);
+bool vehicle_is_stationary(void);
+
+#endif /* INC_CAN_DECODE_H_ */
@@ -0,0 +1,30 @@
+/*
+ * can_filter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_CAN_FILTER_H_
+#define INC_CAN_FILTER_H_
+
+#include "can.h"
+#include <stdint.h>
+
+#define CAN_FILTER_BANKS 28 // CAN1 TAKES ALL BANKS, CAN2 IS UNUSED
+
+/* 1: append a 16-bit accept-all mask bank to FIFO0 (bus discovery), 0: table IDs only */
+#ifndef CAN_FILTER_ACCEPT_ALL
+#define CAN_FILTER_ACCEPT_ALL 0
+#endif
+
+typedef struct {
+	uint16_t id;	// 11-BIT STANDARD ID
+	uint8_t fifo;	// CAN_FILTER_FIFO0 OR CAN_FILTER_FIFO1 (PRIORITY)
+} can_filter_entry_t;
+
+extern uint8_t can_filter_banks_used;
+
+uint8_t can_filter_apply(CAN_HandleTypeDef *hcan);
+
+#endif /* INC_CAN_FILTER_H_ */
@@ -11,13 +11,27 @@
 #include "can_ring_buffer.h"
 #include <stdbool.h>
 
-extern volatile can_ring_buffer_t can_rb;
+#define CAN_RB_CAPACITY 32 // POWER OF TWO
+#define CAN_RB_PRIORITY_CAPACITY 16 // FIFO1 IDS, POWER OF TWO
+
+/* bxCAN-side losses, separate from the software ring drop counters */
+typedef struct {
+	uint32_t fifo0_overrun; // FRAME LOST IN HARDWARE, 3-DEEP FIFO WAS FULL
+	uint32_t fifo1_overrun;
+	uint32_t fifo0_full; // FIFO REACHED 3 PENDING, NEAR MISS
+	uint32_t fifo1_full;
+} can_hw_stats_t;
+
+extern can_ring_buffer_t can_rb;
+extern can_ring_buffer_t can_rb_priority;
+extern volatile can_hw_stats_t can_hw_stats;
 extern volatile bool can_frame_received_flag;
 extern volatile uint32_t last_can_frame;
 
 void can_handler_init(void);
 
 void CAN_Handler_RecoverBusOff(void);
+void can_handler_dump(void);	// HARDWARE AND RING LOSS COUNTERS TO THE DEBUG UART
 
 
 
@@ -15,22 +15,37 @@ typedef struct {
     uint32_t id;
     uint8_t dlc;        // data length, 0-8
     uint8_t data[8];
-    uint32_t timestamp; // when it was received, useful for logging
+    uint32_t timestamp; // timebase_now_us() at reception, wraps every ~71 min
 } can_frame_t;
 
+/*
+ * Single-producer (CAN RX ISR) / single-consumer (main loop) queue.
+ * head is written only by the producer and tail only by the consumer, both
+ * free-running so count = head - tail; capacity must be a power of two.
+ * When full the new frame is dropped and counted, never an unread one.
+ */
 typedef struct {
 	can_frame_t *buffer;
-	uint16_t head;
-	uint16_t tail;
-	uint16_t count;
-	uint16_t capacity;
-	uint16_t dropped_count;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	uint32_t mask;		// capacity - 1
+	volatile uint32_t dropped_count;
 } can_ring_buffer_t;
 
 
-void CANRingBuffer_Init(volatile can_ring_buffer_t*, uint16_t, can_frame_t*);
-bool CANRingBuffer_Push(volatile can_ring_buffer_t*, can_frame_t);
-bool CANRingBuffer_Pop(volatile can_ring_buffer_t*, can_frame_t*);
+bool CANRingBuffer_Init(can_ring_buffer_t*, uint32_t, can_frame_t*);
+
+/* PRODUCER: claim a slot, fill it in place, then commit to publish it */
+can_frame_t *CANRingBuffer_Claim(can_ring_buffer_t*);
+void CANRingBuffer_Commit(can_ring_buffer_t*);
+bool CANRingBuffer_Push(can_ring_buffer_t*, const can_frame_t*);
+
+/* CONSUMER: peek at the oldest frame, then release it once it has been used */
+const can_frame_t *CANRingBuffer_Peek(can_ring_buffer_t*);
+void CANRingBuffer_Release(can_ring_buffer_t*);
+bool CANRingBuffer_Pop(can_ring_buffer_t*, can_frame_t*);
+
+uint32_t CANRingBuffer_Count(const can_ring_buffer_t*);
 
 
 
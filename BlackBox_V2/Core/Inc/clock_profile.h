@@ -0,0 +1,62 @@
+/*
+ * clock_profile.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_CLOCK_PROFILE_H_
+#define INC_CLOCK_PROFILE_H_
+
+#include "fsm_sys.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Runtime clock profiles. The PLL stays at 180 MHz (scale 1, over-drive, set
+ * once in SystemClock_Config) and a switch only rewrites the AHB/APB
+ * prescalers, so it takes a few microseconds and never passes through HSI.
+ *
+ * PCLK1 is 45 MHz in every profile: CAN, I2C1/3, SPI2 and UART2/3/4 keep
+ * their bit timing and the controller never leaves the bus. What does move
+ * is recomputed on each switch: SysTick, TIM2 (timebase), SPI1 (SD card)
+ * and the scheduler's cycles-per-microsecond.
+ */
+typedef enum {
+	CLOCK_IDLE,		// HCLK 45 MHZ, WAITING FOR CAN
+	CLOCK_LOGGING,	// HCLK 90 MHZ, THE PRE-PROFILE CLOCK
+	CLOCK_BURST,	// HCLK 180 MHZ WHILE BUS LOAD PEAKS
+	CLOCK_PROFILE_COUNT
+} clock_profile_t;
+
+/* Burst while logging: entered on either signal, left after a quiet hold */
+#define CLOCK_LOAD_WINDOW_MS    100
+#define CLOCK_BURST_ENTER_FPS   2500	// ~60% OF 500 KBPS WITH 8-BYTE STANDARD FRAMES
+#define CLOCK_BURST_EXIT_FPS    1000
+#define CLOCK_BURST_ENTER_FILL  2		// RING AT 1/2 CAPACITY WHEN SAMPLED
+#define CLOCK_BURST_HOLD_MS     1000
+
+/* Per profile, since boot; time and frames give the drain throughput */
+typedef struct {
+	uint32_t entries;
+	uint64_t time_us;
+	uint32_t frames;		// CAN FRAMES ADMITTED TO THE RINGS WHILE ACTIVE
+	uint32_t switch_max_cycles;	// PRESCALER WRITE TO PERIPHERALS RETUNED, AT THE NEW CLOCK
+} clock_profile_stats_t;
+
+void clock_profile_init(void);
+
+/* Select by FSM state and CAN load; call from one task, after SYS_FSM_TICK */
+void clock_profile_update(sys_state_t state);
+
+bool clock_profile_set(clock_profile_t p);
+uint32_t clock_profile_resume(uint32_t wake_cycles);	// AFTER STOP MODE, INTERRUPTS STILL MASKED
+clock_profile_t clock_profile_current(void);
+const char *clock_profile_name(clock_profile_t p);
+uint32_t clock_profile_hclk(clock_profile_t p);
+
+/* Copy with the running profile's time brought up to now */
+void clock_profile_stats(clock_profile_t p, clock_profile_stats_t *out);
+void clock_profile_dump(void);
+
+#endif /* INC_CLOCK_PROFILE_H_ */
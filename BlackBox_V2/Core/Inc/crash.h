@@ -0,0 +1,82 @@
+/*
+ * crash.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_CRASH_H_
+#define INC_CRASH_H_
+
+#include "main.h"
+#include "fsm_sys.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Post-mortem in backup SRAM (4 KB at BKPSRAM_BASE), which keeps its contents
+ * through every reset but a power cycle. The scheduler marks the running task
+ * and task_health checkpoints the FSM state and ring indices, so a watchdog
+ * reset still says where it hung; HardFault and Error_Handler add the fault
+ * registers and reset at once instead of spinning into the IWDG. crash_init
+ * takes the record and the reset cause at boot, and the first session after
+ * boot logs them as a BBX_REC_CRASH record.
+ */
+#define CRASH_MAGIC    0x48535243UL	// "CRSH"
+#define CRASH_NO_TASK  0xFF			// BETWEEN SCHEDULER TASKS
+
+typedef enum {
+	CRASH_NONE,				// NO FAULT HANDLER RAN; THE CHECKPOINT FIELDS STILL HOLD
+	CRASH_HARDFAULT,		// MEMMANAGE, BUSFAULT AND USAGEFAULT ESCALATE HERE
+	CRASH_ERROR_HANDLER
+} crash_kind_t;
+
+/* Decoded from RCC->CSR, most specific first */
+typedef enum {
+	RESET_POWER_ON,
+	RESET_PIN,				// NRST: BUTTON OR DEBUGGER
+	RESET_BROWNOUT,
+	RESET_SOFTWARE,			// NVIC_SystemReset, INCLUDING OUR OWN AFTER A FAULT
+	RESET_IWDG,
+	RESET_WWDG,
+	RESET_LOW_POWER			// ILLEGAL STOP/STANDBY ENTRY (OPTION BYTES)
+} reset_cause_t;
+
+typedef struct {
+	uint32_t magic;
+	uint8_t kind;			// crash_kind_t
+	uint8_t state;			// sys_state_t
+	uint8_t task;			// SCHEDULER INDEX, CRASH_NO_TASK OUTSIDE ONE
+	uint8_t held;			// SET BY crash_init: BKPSRAM HELD THE PREVIOUS RUN
+	uint32_t uptime_ms;		// AT THE FAULT OR THE LAST CHECKPOINT
+	uint32_t r[8];			// STACKED R0-R3, R12, LR, PC, xPSR; ERROR_HANDLER: PC IS THE CALLER
+	uint32_t exc_return;
+	uint32_t sp;
+	uint32_t cfsr;
+	uint32_t hfsr;
+	uint32_t mmfar;
+	uint32_t bfar;
+	uint32_t can_head, can_tail, can_dropped;
+	uint32_t prio_head, prio_tail, prio_dropped;
+	uint32_t staged;		// SD BYTES STAGED AND NOT YET WRITTEN
+} crash_record_t;
+
+#define CRASH_BKP ((volatile crash_record_t *)BKPSRAM_BASE)
+
+/* Read and clear the reset flags, take the previous run's record and re-arm it; before the scheduler starts */
+void crash_init(void);
+
+/* Breadcrumbs, cheap enough for every dispatch */
+static inline void crash_task(uint8_t index){
+	CRASH_BKP->task = index;
+}
+void crash_checkpoint(void);
+
+/* Reset cause and record from the previous run; pending until the session log has it */
+reset_cause_t crash_reset_cause(void);
+bool crash_pending(const crash_record_t **out);
+void crash_logged(void);
+
+void crash_error_handler(uint32_t caller) __attribute__((noreturn));
+
+#endif /* INC_CRASH_H_ */
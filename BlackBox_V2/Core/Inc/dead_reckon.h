@@ -0,0 +1,61 @@
+/*
+ * dead_reckon.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_DEAD_RECKON_H_
+#define INC_DEAD_RECKON_H_
+
+#include "imu.h"
+#include "imu_filter.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Position propagator between GPS fixes: CAN vehicle speed (GPS speed when
+ * the bus is quiet) along a heading integrated from yaw rate. Stepped by every
+ * filtered IMU sample and snapped to every fix, both in log time order, all
+ * in integer math.
+ */
+#ifndef DR_OUT_HZ
+#define DR_OUT_HZ 50	// INTERPOLATED POSITIONS PER SECOND, 20..100
+#endif
+#if (DR_OUT_HZ < 20) || (DR_OUT_HZ > 100) || (DR_OUT_HZ > IMU_LOG_RATE_HZ)
+#error "DR_OUT_HZ must be 20..100 and no faster than IMU_LOG_RATE_HZ"
+#endif
+
+/* 0: yaw rate from gyro Z, 1: from lateral acceleration over speed (gyro-less mounting) */
+#ifndef DR_YAW_FROM_ACCEL
+#define DR_YAW_FROM_ACCEL 0
+#endif
+#define DR_YAW_SIGN -1	// Z UP: A COUNTER-CLOCKWISE (LEFT) TURN LOWERS THE COMPASS HEADING
+
+#define DR_SNAP_MAX_MM        5000	// LARGEST POSITION STEP TAKEN TOWARDS ONE FIX
+#define DR_RESET_MM           100000	// FARTHER THAN THIS: RE-ANCHOR ON THE FIX OUTRIGHT
+#define DR_HEADING_SNAP_CDEG  500	// LARGEST HEADING STEP TOWARDS THE GPS COURSE PER FIX
+#define DR_COURSE_MIN_MMPS    2000	// GPS COURSE IS NOISE BELOW ~7 KPH
+#define DR_MAX_COAST_MS       10000	// STOP EMITTING THIS LONG AFTER THE LAST FIX
+#define DR_MAX_STEP_US        20000	// CLAMP FOR GAPS IN THE IMU STREAM
+
+typedef struct {
+	bool valid;				// ANCHORED, HEADING KNOWN, FIX RECENT
+	int32_t lat_e7;			// REFRESHED BY dead_reckon_emit
+	int32_t lon_e7;
+	uint16_t heading_cdeg;
+	int32_t speed_mmps;
+	uint32_t timestamp;		// LAST STEP
+	uint32_t snaps;
+	uint32_t resets;
+	uint32_t last_error_mm;	// DISTANCE TO THE LAST FIX BEFORE ITS CORRECTION
+} dead_reckon_t;
+
+extern dead_reckon_t dead_reckon;
+
+void dead_reckon_reset(void);
+void dead_reckon_step(const imu_frame *sample);	// FILTERED SAMPLE, IN TIME ORDER
+void dead_reckon_fix(void);						// gps HOLDS A NEW FIX
+bool dead_reckon_emit(void);					// TRUE ONCE PER 1/DR_OUT_HZ WITH lat/lon REFRESHED
+
+#endif /* INC_DEAD_RECKON_H_ */
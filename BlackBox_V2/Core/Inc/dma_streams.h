@@ -0,0 +1,14 @@
+/*
+ * dma_streams.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_DMA_STREAMS_H_
+#define INC_DMA_STREAMS_H_
+
+/* DMA1/DMA2 clocks and stream IRQs; before any MspInit links a stream */
+void dma_streams_init(void);
+
+#endif /* INC_DMA_STREAMS_H_ */
@@ -0,0 +1,42 @@
+/*
+ * geo.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_GEO_H_
+#define INC_GEO_H_
+
+#include <stdint.h>
+
+/*
+ * Positions are int32 1e-7 degrees as parsed (gps_fix_t). Over the distances
+ * between consecutive fixes a local flat-earth projection on the 6371 km
+ * sphere is well inside receiver noise, and needs no float or libm.
+ */
+#define GEO_MM_PER_E7_NUM 1111949	// 11.11949 MM PER 1e-7 DEG OF ARC, SAME SPHERE AS map_gen.py
+#define GEO_MM_PER_E7_DEN 100000
+#define GEO_DELTA_MAX_MM  (1L << 30)	// ~1070 KM, LEGS ARE CLAMPED HERE
+
+/* cos(latitude) in q15, table plus linear interpolation */
+int32_t geo_cos_q15(int32_t lat_e7);
+
+/* Unit vector of a heading (0.01 deg from north): north = cos, east = sin, q15 */
+void geo_sin_cos_q15(uint16_t heading_cdeg, int32_t *sin_q15, int32_t *cos_q15);
+
+/* North/east offset of point 2 from point 1 */
+void geo_delta_mm(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7, int32_t *north_mm, int32_t *east_mm);
+
+uint32_t geo_distance_mm(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7);
+
+/* Direction of a north/east vector, 0.01 deg clockwise from true north, 0..35999 */
+uint16_t geo_heading_cdeg(int32_t north_mm, int32_t east_mm);
+
+/* Bearing from point 1 to point 2, as geo_heading_cdeg */
+uint16_t geo_bearing_cdeg(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7);
+
+/* Move a position by a north/east offset in place */
+void geo_offset(int32_t *lat_e7, int32_t *lon_e7, int32_t north_mm, int32_t east_mm);
+
+#endif /* INC_GEO_H_ */
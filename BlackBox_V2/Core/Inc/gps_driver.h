@@ -8,6 +8,88 @@
 #ifndef GPS_DRIVER_H_
 #define GPS_DRIVER_H_
 
+#include "nmea_parser.h"
+#include "ubx_parser.h"
+#include <stdint.h>
+#include <stdbool.h>
 
+#define GPS_BAUD 9600		// RECEIVER POWER-ON DEFAULT, NMEA
+#define GPS_UBX_BAUD 115200	// AFTER CONFIGURATION, UBX ONLY
+
+/*
+ * Navigation rate in UBX mode. The NEO-6M tops out at 5 Hz (200 ms); 100 ms
+ * is only accepted by later generations and is NAK'd, which falls back to NMEA.
+ */
+#define GPS_UBX_RATE_MS 200
+
+/* Set to 0 to leave the receiver at its 9600 baud NMEA defaults */
+#define GPS_UBX_ENABLE 1
+
+/*
+ * Sized by data rate, not baud: 2 KB is ~2 s of continuous 9600 baud NMEA
+ * and ~2 s of 5 Hz UBX at 115200, so a 500 ms SD busy stall in the main loop
+ * cannot lap the reader.
+ */
+#define GPS_RX_BUFFER_SIZE 2048 // POWER OF TWO
+#define GPS_SENTENCE_MAX   96	// NMEA CAPS SENTENCES AT 82 CHARACTERS
+
+/* Integer fixed point end to end; convert to degrees/kph only on the host */
+typedef struct {
+	bool locked;
+	uint8_t fix_type;	// 1 = NONE, 2 = 2D, 3 = 3D
+	uint8_t sats;
+	int32_t lat_e7;		// 1e-7 DEG
+	int32_t lon_e7;		// 1e-7 DEG
+	int32_t alt_mm;		// MSL
+	int32_t speed_mmps;
+	int32_t course_cdeg;	// 0.01 DEG FROM TRUE NORTH
+	uint32_t timestamp; // timebase_now_us() when the fix was received
+	uint32_t seq;		// BUMPED ON EVERY UPDATE, LETS CONSUMERS SPOT NEW FIXES
+} gps_data_t;
+
+/* Latest trusted UTC time message and when its burst started; timesync.c labels PPS edges with it */
+typedef struct {
+	uint32_t utc_ms;	// UTC MILLISECONDS OF DAY OF THE EPOCH
+	uint32_t date;		// DDMMYY
+	uint32_t timestamp;
+	uint32_t seq;
+} gps_time_t;
+
+/*
+ * One sentence ('$' through '\n') still sitting in the DMA buffer. A sentence
+ * that wraps the end of the buffer is split into two spans; len[1] is 0 otherwise.
+ */
+typedef struct {
+	const uint8_t *p[2];
+	uint16_t len[2];
+	uint32_t timestamp;	// timebase_now_us() AT THE FIRST BYTE OF ITS BURST
+} gps_sentence_t;
+
+typedef enum {
+	GPS_MODE_NMEA,		// DEFAULT, OR FALLBACK AFTER A FAILED CONFIGURATION
+	GPS_MODE_CONFIG,	// UBX CONFIGURATION SEQUENCE IN FLIGHT
+	GPS_MODE_UBX
+} gps_mode_t;
+
+/* Ingest counters */
+typedef struct {
+	uint32_t bytes;
+	uint32_t sentences;
+	uint32_t overruns;	// READER WAS LAPPED, BYTES LOST
+	uint32_t uart_errors;	// NOISE/FRAMING/ORE, RECEPTION RESTARTED
+	uint32_t oversize;	// NO '\n' WITHIN GPS_SENTENCE_MAX
+	uint32_t ubx_frames;	// UBX CHECKSUM PASSED
+	uint32_t ubx_errors;
+	uint32_t cfg_failures;	// CONFIGURATION NOT ACKNOWLEDGED, FELL BACK TO NMEA
+} gps_stats_t;
+
+extern gps_data_t gps;
+extern gps_stats_t gps_stats;
+extern gps_fix_t gps_fix;	// FULL-RESOLUTION FIELDS AS PARSED
+extern gps_mode_t gps_mode;
+extern gps_time_t gps_time;
+
+void GPS_Driver_Init(void);
+void GPS_Driver_Update(void);
 
 #endif /* GPS_DRIVER_H_ */
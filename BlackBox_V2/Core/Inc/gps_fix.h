@@ -0,0 +1,30 @@
+/*
+ * gps_fix.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_GPS_FIX_H_
+#define INC_GPS_FIX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Receiver solution in integer fixed point, filled by the NMEA or UBX parser */
+typedef struct {
+	int32_t lat_e7;			// 1e-7 DEG, NORTH POSITIVE
+	int32_t lon_e7;			// 1e-7 DEG, EAST POSITIVE
+	int32_t alt_mm;			// MSL (GGA)
+	int32_t speed_mmps;		// GROUND SPEED (RMC KNOTS OR VTG KPH)
+	int32_t course_cdeg;	// TRUE COURSE, 0.01 DEG
+	uint32_t time_ms;		// UTC MILLISECONDS OF DAY
+	uint32_t date;			// DDMMYY AS AN INTEGER, 0 UNTIL RMC
+	uint16_t hdop_c;		// HDOP x100
+	uint8_t quality;		// GGA FIX QUALITY, 0 = NONE (UBX: 1 WITH A FIX)
+	uint8_t fix_type;		// 1 = NONE, 2 = 2D, 3 = 3D (GSA OR UBX)
+	uint8_t sats;			// GGA SATELLITES USED
+	bool rmc_valid;			// RMC STATUS 'A' (UBX: FIX OK FLAG)
+} gps_fix_t;
+
+#endif /* INC_GPS_FIX_H_ */
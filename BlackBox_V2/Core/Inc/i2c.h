@@ -37,6 +37,7 @@ extern I2C_HandleTypeDef hi2c1;
 extern I2C_HandleTypeDef hi2c3;
 
 /* USER CODE BEGIN Private defines */
+extern DMA_HandleTypeDef hdma_i2c1_rx;
 
 /* USER CODE END Private defines */
 
@@ -9,26 +9,58 @@
 #define INC_IMU_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
+/* 1: 1 kHz sampling drained in bursts from the MPU6050 FIFO, 0: 100 Hz data-ready reads */
+#ifndef IMU_FIFO_MODE
+#define IMU_FIFO_MODE 1
+#endif
+
+#if IMU_FIFO_MODE
+#define IMU_SAMPLE_RATE_HZ 1000	// 1 kHz / (1 + SMPLRT_DIV)
+#define IMU_RB_CAPACITY    128	// POWER OF TWO, ~128 MS OF MAIN LOOP SLACK
+#else
+#define IMU_SAMPLE_RATE_HZ 100
+#define IMU_RB_CAPACITY    32	// POWER OF TWO
+#endif
+
+/* Raw sensor counts: accel +-2 g (16384/g), gyro +-250 dps (131/dps), temp C = raw/340 + 36.53 */
 typedef struct {
 	int16_t accel_x;
 	int16_t accel_y;
 	int16_t accel_z;
-	int32_t timestamp;
+	int16_t gyro_x;
+	int16_t gyro_y;
+	int16_t gyro_z;
+	int16_t temp;
+	uint32_t timestamp; // timebase_now_us() of the sample
 } imu_frame;
 
 typedef struct {
 	int16_t offset_x;
 	int16_t offset_y;
 	int16_t offset_z;
+	int16_t offset_gx;
+	int16_t offset_gy;
+	int16_t offset_gz;
 } imu_calibration;
 
 extern imu_frame imu;
 extern imu_calibration imu_offset;
 extern uint8_t imu_who_am_i;
+extern volatile uint32_t imu_dropped_count;	// RING FULL
+extern volatile uint32_t imu_missed_count;	// DATA READY WHILE THE PREVIOUS READ WAS IN FLIGHT
+extern volatile uint32_t imu_overflow_count;	// HARDWARE FIFO OVERFLOWED OR LOST FRAME ALIGNMENT, RESET
 
 void imu_init(void);
-void imu_read(void);
+void imu_read(void);	// NON-BLOCKING: LATEST QUEUED SAMPLE INTO imu
+bool imu_streaming(void);
+uint32_t imu_horizon(void);	// EVERY SAMPLE UP TO THIS TIMESTAMP IS ALREADY QUEUED
+
+/* CONSUMER: peek the oldest queued sample, release it when done */
+const imu_frame *imu_ring_peek(void);
+void imu_ring_release(void);
+bool imu_ring_pop(imu_frame *out);
 void imu_calibrate(void);
 
 #endif /* INC_IMU_H_ */
@@ -0,0 +1,32 @@
+/*
+ * imu_cal.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_IMU_CAL_H_
+#define INC_IMU_CAL_H_
+
+#include "imu.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Offsets live in RTC backup registers DR1..DR5 (DR0 is left to the CubeMX RTC
+ * init check). They survive resets and, with VBAT fitted, power-off.
+ */
+#define IMU_CAL_WINDOW_SAMPLES IMU_SAMPLE_RATE_HZ	// ONE SECOND PER REFINEMENT WINDOW
+#define IMU_CAL_EMA_SHIFT      4					// EACH WINDOW MOVES THE OFFSET 1/16 OF THE RESIDUAL
+#define IMU_CAL_ACCEL_VAR_MAX  (200L * 200L)		// ~12 mg RMS: ENGINE IDLE YES, DOORS/PASSENGERS NO
+#define IMU_CAL_GYRO_VAR_MAX   (100L * 100L)		// ~0.8 DPS RMS
+
+extern uint32_t imu_cal_updates;
+
+bool imu_cal_load(imu_calibration *cal);
+void imu_cal_save(const imu_calibration *cal);
+
+/* Feed every offset-corrected sample the main loop consumes */
+void imu_cal_observe(const imu_frame *sample);
+
+#endif /* INC_IMU_CAL_H_ */
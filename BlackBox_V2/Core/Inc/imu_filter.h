@@ -0,0 +1,44 @@
+/*
+ * imu_filter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_IMU_FILTER_H_
+#define INC_IMU_FILTER_H_
+
+#include "imu.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Logged IMU rate, independent of IMU_SAMPLE_RATE_HZ; must divide it. Equal rates bypass the filter */
+#ifndef IMU_LOG_RATE_HZ
+#if IMU_SAMPLE_RATE_HZ >= 200
+#define IMU_LOG_RATE_HZ 200
+#else
+#define IMU_LOG_RATE_HZ IMU_SAMPLE_RATE_HZ	// IMU_FIFO_MODE 0: LOG EVERY 100 HZ SAMPLE
+#endif
+#endif
+
+#define IMU_FILTER_TAPS 48	// EVEN: TAPS ARE CONSUMED IN PAIRS BY SMLAD
+#define IMU_FILTER_DECIMATION (IMU_SAMPLE_RATE_HZ / IMU_LOG_RATE_HZ)
+
+#if (IMU_SAMPLE_RATE_HZ % IMU_LOG_RATE_HZ) != 0
+#error "IMU_LOG_RATE_HZ must divide IMU_SAMPLE_RATE_HZ"
+#endif
+
+/* Linear-phase group delay; filtered samples are stamped this much before the newest input */
+#if IMU_FILTER_DECIMATION > 1
+#define IMU_FILTER_DELAY_US ((uint32_t)(((IMU_FILTER_TAPS - 1) * 1000000ULL) / (2ULL * IMU_SAMPLE_RATE_HZ)))
+#else
+#define IMU_FILTER_DELAY_US 0U
+#endif
+
+void imu_filter_init(void);
+void imu_filter_reset(void);
+
+/* Feed one sensor sample; true when a decimated, anti-aliased sample was written to *out */
+bool imu_filter_push(const imu_frame *in, imu_frame *out);
+
+#endif /* INC_IMU_FILTER_H_ */
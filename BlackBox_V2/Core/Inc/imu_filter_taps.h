@@ -0,0 +1,58 @@
+/*
+ * imu_filter_taps.h
+ *
+ * GENERATED by tools/gen_imu_taps.py, do not edit; change the design there
+ * and regenerate.
+ */
+
+#ifndef INC_IMU_FILTER_TAPS_H_
+#define INC_IMU_FILTER_TAPS_H_
+
+#include <stdint.h>
+
+/* 48-tap Hamming-windowed sinc, cutoff at 80% of the output Nyquist rate, q15, taps sum to 32767 */
+#if IMU_FILTER_TAPS != 48
+#error "imu_filter_taps.h was generated for a different IMU_FILTER_TAPS"
+#endif
+
+#if IMU_FILTER_DECIMATION == 2
+static const int16_t imu_filter_coeffs[IMU_FILTER_TAPS] = {
+	   -34,      0,     44,     35,    -45,    -96,      0,    161,
+	   126,   -159,   -319,      0,    479,    360,   -437,   -857,
+	     0,   1278,    983,  -1253,  -2696,      0,   6556,  12255,
+	 12260,   6556,      0,  -2696,  -1253,    983,   1278,      0,
+	  -857,   -437,    360,    479,      0,   -319,   -159,    126,
+	   161,      0,    -96,    -45,     35,     44,      0,    -34,
+};
+#elif IMU_FILTER_DECIMATION == 4
+static const int16_t imu_filter_coeffs[IMU_FILTER_TAPS] = {
+	    29,     39,     38,     18,    -24,    -81,   -131,   -136,
+	   -66,     83,    270,    411,    407,    189,   -229,   -727,
+	 -1093,  -1084,   -515,    657,   2287,   4057,   5561,   6425,
+	  6422,   5561,   4057,   2287,    657,   -515,  -1084,  -1093,
+	  -727,   -229,    189,    407,    411,    270,     83,    -66,
+	  -136,   -131,    -81,    -24,     18,     38,     39,     29,
+};
+#elif IMU_FILTER_DECIMATION == 5
+static const int16_t imu_filter_coeffs[IMU_FILTER_TAPS] = {
+	   -24,    -37,    -46,    -46,    -28,     13,     77,    153,
+	   215,    228,    162,      0,   -243,   -518,   -743,   -817,
+	  -645,   -169,    617,   1646,   2790,   3877,   4728,   5196,
+	  5191,   4728,   3877,   2790,   1646,    617,   -169,   -645,
+	  -817,   -743,   -518,   -243,      0,    162,    228,    215,
+	   153,     77,     13,    -28,    -46,    -46,    -37,    -24,
+};
+#elif IMU_FILTER_DECIMATION == 10
+static const int16_t imu_filter_coeffs[IMU_FILTER_TAPS] = {
+	   -13,    -23,    -36,    -53,    -76,   -100,   -124,   -142,
+	  -146,   -129,    -83,      0,    125,    294,    507,    758,
+	  1039,   1337,   1637,   1922,   2176,   2383,   2529,   2604,
+	  2599,   2529,   2383,   2176,   1922,   1637,   1337,   1039,
+	   758,    507,    294,    125,      0,    -83,   -129,   -146,
+	  -142,   -124,   -100,    -76,    -53,    -36,    -23,    -13,
+};
+#elif IMU_FILTER_DECIMATION > 1
+#error "no tap table for this IMU_FILTER_DECIMATION; add it to DECIMATIONS in tools/gen_imu_taps.py"
+#endif
+
+#endif /* INC_IMU_FILTER_TAPS_H_ */
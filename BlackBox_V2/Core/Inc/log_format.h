@@ -0,0 +1,79 @@
+/*
+ * log_format.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_LOG_FORMAT_H_
+#define INC_LOG_FORMAT_H_
+
+/*
+ * Binary session log (.bbx). Shared contract with tools/bbx_decode.py; bump
+ * BBX_VERSION on any layout change. All multi-byte fields are little-endian.
+ *
+ * File header (BBX_HEADER_SIZE bytes):
+ *   0  char[4]  magic "BBXL"
+ *   4  u8       version
+ *   5  u8       header size
+ *   6  u16      flags (reserved, 0)
+ *   8  u32      timestamp ticks per second
+ *   12 u32      session start timestamp
+ *
+ * Records follow back to back, each starting with a one-byte type. "dt" is the
+ * u16 tick delta from the previous record's timestamp (the header start
+ * timestamp for the first record). A gap that does not fit in u16 is preceded
+ * by a BBX_REC_TIME record carrying the absolute timestamp, with dt 0 after it.
+ * Timestamps are u32 and wrap; decoders unwrap TIME records forward in time.
+ *
+ *   BBX_REC_CAN      u8 type, u16 dt, u16 id, u8 dlc, u8 data[dlc]
+ *   BBX_REC_CAN_IMU  as BBX_REC_CAN, then i16 ax, ay, az (IMU changed since last record)
+ *   BBX_REC_IMU      u8 type, u16 dt, i16 ax, ay, az (IMU-only row when the bus is quiet)
+ *   BBX_REC_IMU6     u8 type, u16 dt, i16 ax, ay, az, gx, gy, gz, temp (filtered, at
+ *                    IMU_LOG_RATE_HZ; while these stream, CAN records carry no IMU triple)
+ *   BBX_REC_GPS      u8 type, u16 dt, i32 lat, i32 lon (1e-7 deg), i32 alt (mm MSL),
+ *                    i32 speed (mm/s), u16 course (0.01 deg), u8 fix (bits 0-3 fix type
+ *                    1/2/3, bit 7 locked), u8 satellites; dt is the fix's burst time
+ *   BBX_REC_DR       u8 type, u16 dt, i32 lat, i32 lon (1e-7 deg), u16 heading (0.01 deg),
+ *                    u16 speed (cm/s); dead-reckoned position at DR_OUT_HZ between fixes
+ *   BBX_REC_SYNC     u8 type, u32 PPS edge timestamp (absolute), u32 date DDMMYY (0 = unknown),
+ *                    u32 UTC ms of day at the edge, i32 timebase drift (ppb, + = fast); one
+ *                    per labelled PPS edge, untimed, no dt. UTC of any record is found by
+ *                    interpolating its timestamp between the SYNC edges around it
+ *   BBX_REC_PROF     u8 type, u32 timestamp (absolute, end of the interval), u32 core clock (Hz),
+ *                    u8 name length n, char name[n], u32 count, u32 min, u32 max, u32 mean (cycles),
+ *                    u8 first bin f, u8 bin count m, u32 hist[m] (runs of 2^(f+i) .. 2^(f+i+1)-1
+ *                    cycles); one per profiling probe that ran in the interval, untimed, no dt
+ *   BBX_REC_CRASH    u8 type, u8 reset cause, u8 kind, u8 held, u8 sys_state, u8 task,
+ *                    u32 uptime (ms), u32 r0, r1, r2, r3, r12, lr, pc, xpsr, u32 exc_return,
+ *                    u32 sp, u32 cfsr, hfsr, mmfar, bfar, u32 CAN ring head, tail, dropped,
+ *                    u32 priority ring head, tail, dropped, u32 SD bytes staged (crash.h);
+ *                    the previous run's post-mortem, straight after the header of the first
+ *                    session after an abnormal reset, untimed, no dt
+ *   BBX_REC_TIME     u8 type, u32 absolute timestamp
+ *   BBX_REC_SKIP     u8 type, u16 id, u16 count (frames of id dropped by log_policy.c
+ *                    since its previous SKIP record; untimed, no dt)
+ */
+
+#define BBX_MAGIC0        'B'
+#define BBX_MAGIC1        'B'
+#define BBX_MAGIC2        'X'
+#define BBX_MAGIC3        'L'
+#define BBX_VERSION       9	// V2: MICROSECOND TICKS FROM timebase.h, V3: SKIP, V4: IMU6, V5: GPS, V6: SYNC, V7: DR, V8: PROF, V9: CRASH
+#define BBX_HEADER_SIZE   16
+
+#define BBX_REC_CAN       0x01
+#define BBX_REC_CAN_IMU   0x02
+#define BBX_REC_IMU       0x03
+#define BBX_REC_SKIP      0x04
+#define BBX_REC_IMU6      0x05
+#define BBX_REC_GPS       0x06
+#define BBX_REC_SYNC      0x07
+#define BBX_REC_DR        0x08
+#define BBX_REC_PROF      0x09
+#define BBX_REC_CRASH     0x0A
+#define BBX_REC_TIME      0x10
+
+#define BBX_REC_MAX_SIZE  (5 + 5 + 6 + 8 + 6)	// SKIP + TIME PREFIX + LARGEST CAN_IMU RECORD (TIME + GPS IS 28)
+
+#endif /* INC_LOG_FORMAT_H_ */
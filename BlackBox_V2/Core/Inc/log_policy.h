@@ -0,0 +1,42 @@
+/*
+ * log_policy.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_LOG_POLICY_H_
+#define INC_LOG_POLICY_H_
+
+#include "can_ring_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+	LOG_POLICY_EVERY,		// LOG EVERY FRAME
+	LOG_POLICY_ON_CHANGE,	// LOG WHEN DLC/PAYLOAD DIFFERS, PLUS A REFRESH EVERY period_ms IF NON-ZERO
+	LOG_POLICY_RATE_LIMIT,	// LOG AT MOST ONE FRAME PER period_ms
+	LOG_POLICY_DROP			// COUNT ONLY
+} log_policy_mode_t;
+
+typedef struct {
+	uint16_t id;			// 11-BIT STANDARD ID
+	uint8_t mode;			// log_policy_mode_t
+	uint16_t period_ms;
+} log_policy_entry_t;
+
+/* IDs missing from the policy table (accept-all discovery) are logged every frame */
+#define LOG_POLICY_DEFAULT_MODE LOG_POLICY_EVERY
+
+/* How often pending suppressed counts are written even if the ID never logs again */
+#define LOG_POLICY_SUMMARY_MS 1000
+
+void log_policy_reset(void);
+
+/* true: log this frame. *skipped gets the frames suppressed for this ID since its last logged one */
+bool log_policy_admit(const can_frame_t *frame, uint16_t *skipped);
+
+/* Walk IDs with pending suppressed counts; returns false when done. Clears the count it hands out */
+bool log_policy_next_skipped(uint32_t *cursor, uint16_t *id, uint16_t *skipped);
+
+#endif /* INC_LOG_POLICY_H_ */
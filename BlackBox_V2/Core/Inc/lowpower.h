@@ -0,0 +1,63 @@
+/*
+ * lowpower.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_LOWPOWER_H_
+#define INC_LOWPOWER_H_
+
+#include "fsm_sys.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * STOP mode while SYS_IDLE. bxCAN is put to sleep and the first falling edge
+ * on CAN1_RX (PB8, EXTI8) wakes the core; that frame is lost, the controller
+ * is back on the bus for the next one. The RTC wakeup timer (LSI, like the
+ * IWDG) brings the board up every LOWPOWER_RTC_WAKE_MS to feed the watchdog
+ * and let every task run once. TIM2 and SysTick stop in STOP, so both are
+ * advanced by the sleep time read back from the RTC calendar.
+ *
+ * Build with LOWPOWER_ENABLE 0 to keep the board awake on the bench.
+ */
+#ifndef LOWPOWER_ENABLE
+#define LOWPOWER_ENABLE 1
+#endif
+
+#define LOWPOWER_IDLE_DELAY_MS    10000	// IDLE THIS LONG BEFORE THE FIRST STOP
+#define LOWPOWER_AWAKE_MS         100	// AFTER A WAKE: THE LATEST FIRST RELEASE IN app_tasks IS 50 MS
+#define LOWPOWER_RTC_WAKE_MS      4000	// HALF THE ~8.2 S IWDG TIMEOUT, BOTH ON LSI
+#define LOWPOWER_CAN_SLEEP_MS     5		// bxCAN SLEEPS AT THE END OF THE CURRENT FRAME
+#define LOWPOWER_FIRST_FRAME_MS   1000	// A CAN WAKE WITH NO FRAME BY THEN WAS NOISE
+
+typedef enum {
+	LOWPOWER_WAKE_CAN,
+	LOWPOWER_WAKE_RTC,
+	LOWPOWER_WAKE_OTHER		// TOUCH IRQ OR ANY OTHER ENABLED EXTI
+} lowpower_wake_t;
+
+typedef struct {
+	uint32_t stops;
+	uint32_t aborted;			// A PERIPHERAL WAS MID-TRANSFER OR bxCAN WOULD NOT SLEEP
+	uint32_t wakes[3];			// BY lowpower_wake_t
+	uint32_t asleep_ms;
+	uint32_t wake_us_last;		// FIRST INSTRUCTION AFTER WFI TO bxCAN BACK ON THE BUS
+	uint32_t wake_us_max;
+	uint32_t first_frame_us_last;	// FIRST INSTRUCTION AFTER A CAN WAKE TO THE FIRST FRAME CAPTURED
+	uint32_t first_frame_us_max;
+	uint32_t no_frame;			// CAN WAKES WITH NOTHING CAPTURED WITHIN LOWPOWER_FIRST_FRAME_MS
+} lowpower_stats_t;
+
+extern lowpower_stats_t lowpower_stats;
+
+void lowpower_init(void);
+
+/* Call from one task after SYS_FSM_TICK and clock_profile_update; may sleep before returning */
+void lowpower_update(sys_state_t state);
+
+void lowpower_exti_isr(void);
+void lowpower_dump(void);
+
+#endif /* INC_LOWPOWER_H_ */
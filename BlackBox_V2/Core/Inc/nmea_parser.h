@@ -0,0 +1,60 @@
+/*
+ * nmea_parser.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_NMEA_PARSER_H_
+#define INC_NMEA_PARSER_H_
+
+#include "gps_fix.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Sentence bits, returned by nmea_feed when that sentence passed its checksum */
+#define NMEA_RMC 0x01
+#define NMEA_GGA 0x02
+#define NMEA_VTG 0x04
+#define NMEA_GSA 0x08
+
+#define NMEA_MAX_LEN     82	// '$' THROUGH '\n'
+#define NMEA_MAX_FRAC    7	// FRACTION DIGITS KEPT PER FIELD, THE REST ARE DROPPED
+#define NMEA_MANTISSA_MAX 1000000000000ULL	// 1e12: LONGER NUMBERS MARK THE FIELD BAD
+
+/* One parser per byte stream; all state lives here so several streams can run at once */
+typedef struct {
+	uint8_t state;
+	uint8_t sentence;		// NMEA_* OF THE SENTENCE IN PROGRESS, 0 = IGNORED
+	uint8_t field;
+	uint8_t length;
+	uint8_t checksum;
+	uint8_t checksum_rx;
+	char type[6];			// ADDRESS FIELD, E.G. "GPRMC"
+	uint8_t type_len;
+
+	/* Current field */
+	uint64_t mantissa;
+	uint8_t frac_digits;
+	bool has_digits;
+	bool seen_point;
+	bool negative;
+	bool bad;
+	char letter;
+
+	/* Fields of this sentence; merged into the caller's fix only after the checksum */
+	gps_fix_t stage;
+	uint16_t stage_mask;
+	char hemi_lat;
+	char hemi_lon;
+
+	uint32_t errors;		// CHECKSUM OR FRAMING FAILURES
+} nmea_parser_t;
+
+void nmea_init(nmea_parser_t *p);
+
+/* Feed bytes; returns NMEA_* bits for sentences committed to *fix during this call */
+uint8_t nmea_feed(nmea_parser_t *p, uint8_t c, gps_fix_t *fix);
+uint8_t nmea_feed_span(nmea_parser_t *p, const uint8_t *data, uint16_t len, gps_fix_t *fix);
+
+#endif /* INC_NMEA_PARSER_H_ */
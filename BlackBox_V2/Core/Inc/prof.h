@@ -0,0 +1,71 @@
+/*
+ * prof.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_PROF_H_
+#define INC_PROF_H_
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 1: DWT cycle probes on the hot paths, 0: probes, stats record and dump compile out */
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+/* Probe list: X(id, name). Names go into the log record, keep them short */
+#define PROF_PROBES(X) \
+	X(CAN_RX_ISR, "can_rx_isr")	/* ONE HARDWARE FIFO EMPTIED INTO ITS RING */ \
+	X(SD_DRAIN,   "sd_drain")	/* ONE SD_Logger_DrainCAN PASS */ \
+	X(SD_WRITE,   "sd_write")	/* USER_write: CMD24/CMD25 INCLUDING ANY WAIT ON THE PREVIOUS BUSY */ \
+	X(SD_SECTOR,  "sd_sector")	/* ONE 512 B DATA PHASE, DMA OR POLLED (SD_DMA_ENABLE) */ \
+	X(SD_BLK_BUSY, "sd_blk_busy")	/* CMD25: CARD BUSY BETWEEN TWO BLOCKS OF A BURST */ \
+	X(IMU_READ,   "imu_read")
+
+typedef enum {
+#define PROF_ENUM(id, name) PROF_##id,
+	PROF_PROBES(PROF_ENUM)
+#undef PROF_ENUM
+	PROF_COUNT
+} prof_id_t;
+
+#define PROF_NAME_MAX 12
+#define PROF_BINS 32	// BIN b COUNTS RUNS OF 2^b .. 2^(b+1)-1 CYCLES (BIN 0 ALSO HOLDS 0)
+
+typedef struct {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t hist[PROF_BINS];
+} prof_stats_t;
+
+#if PROF_ENABLE
+
+/* Bracket a path in one scope; a probe costs two CYCCNT reads and one prof_record call */
+#define PROF_START(id) uint32_t prof_t0_##id = DWT->CYCCNT
+#define PROF_STOP(id)  prof_record(PROF_##id, DWT->CYCCNT - prof_t0_##id)
+
+void prof_init(void);
+void prof_record(prof_id_t id, uint32_t cycles);
+void prof_snapshot(prof_id_t id, prof_stats_t *out, bool clear);	// ATOMIC AGAINST ISR PROBES
+void prof_reset(void);
+const char *prof_name(prof_id_t id);
+void prof_dump(void);	// QUEUED TO THE 4 KB TRACE RING AS TEXT; LINES THAT DO NOT FIT ARE DROPPED (trace_dropped)
+
+#else
+
+#define PROF_START(id) ((void)0)
+#define PROF_STOP(id)  ((void)0)
+
+static inline void prof_init(void){}
+static inline void prof_reset(void){}
+static inline void prof_dump(void){}
+
+#endif
+
+#endif /* INC_PROF_H_ */
@@ -0,0 +1,55 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Time-triggered cooperative dispatcher. Tasks are released on the 1 MHz
+ * timebase at fixed periods and run to completion in table order (first
+ * entry = highest priority); the core sleeps in WFI when nothing is due.
+ * Run time is measured in DWT cycles against each task's budget.
+ */
+#define SCHED_MAX_TASKS 8
+
+typedef struct {
+	const char *name;
+	void (*run)(void);
+	uint32_t period_us;
+	uint32_t offset_us;		// FIRST RELEASE, STAGGERS TASKS THAT SHARE A PERIOD
+	uint32_t deadline_us;	// LATEST ACCEPTABLE START AFTER RELEASE
+	uint32_t budget_us;		// LONGEST ACCEPTABLE RUN, CHECKED IN CYCLES
+} sched_task_t;
+
+typedef struct {
+	uint32_t next_release;	// timebase_now_us()
+	uint32_t runs;
+	uint32_t overruns;		// RAN PAST budget_us
+	uint32_t late;			// STARTED PAST deadline_us
+	uint32_t skipped;		// WHOLE PERIODS LOST TO A LATE START
+	uint32_t last_cycles;
+	uint32_t max_cycles;
+	uint32_t max_jitter_us;	// WORST START LATENCY AFTER RELEASE
+	uint32_t last_jitter_us;
+	uint32_t last_start;	// timebase_now_us() OF THE LAST RUN, FOR THE CHECK-IN WINDOW
+} sched_stats_t;
+
+void scheduler_init(const sched_task_t *tasks, uint8_t count);
+void scheduler_clock_update(void);	// AFTER ANY SYSCLK CHANGE
+void scheduler_resync(void);		// AFTER THE TIMEBASE STOPPED OR JUMPED
+bool scheduler_dispatch(void);		// RUN THE HIGHEST-PRIORITY DUE TASK; FALSE IF NONE WAS DUE
+void scheduler_run(void);			// DISPATCH FOREVER, SLEEPING BETWEEN RELEASES
+bool scheduler_check_in_all(void);	// TRUE WHILE EVERY TASK RAN WITHIN ITS OWN PERIOD + DEADLINE
+uint32_t scheduler_cycles_to_us(uint32_t cycles);
+const sched_stats_t *scheduler_stats(uint8_t index);
+const sched_task_t *scheduler_task(uint8_t index);
+uint8_t scheduler_task_count(void);
+
+#endif /* INC_SCHEDULER_H_ */
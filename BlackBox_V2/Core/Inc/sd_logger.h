@@ -11,13 +11,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* 1: compact .bbx records (see log_format.h), 0: legacy CSV rows */
+#ifndef SD_LOG_BINARY
+#define SD_LOG_BINARY 1
+#endif
+
+#if SD_LOG_BINARY
+#define SD_LOG_EXT ".bbx"
+#else
+#define SD_LOG_EXT ".csv"
+#endif
+
 extern volatile bool sd_mount;
 
 bool SD_Logger_Init(void);
 void start_new_session_file(void);
 void close_session_file(void);
+void abort_session_file(void);		// AFTER sd_fault WHILE LOGGING; NOTHING MORE IS WRITTEN
 void sd_recovery(void);
 void unmount_sd(void);
 void flush_ring_buffers(void);
+void SD_Logger_Service(void);		// WRITES AT MOST ONE STAGED BURST, ONLY WHILE THE CARD IS IDLE
+uint32_t SD_Logger_Staged(void);	// BYTES NOT YET HANDED TO FatFs
+uint32_t SD_Logger_Dropped(void);	// STAGED BYTES LOST TO SD ERRORS SINCE BOOT
 
 #endif /* INC_SD_LOGGER_H_ */
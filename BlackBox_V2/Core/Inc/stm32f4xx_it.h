@@ -47,7 +47,6 @@ extern "C" {
 
 /* Exported functions prototypes ---------------------------------------------*/
 void NMI_Handler(void);
-void HardFault_Handler(void);
 void MemManage_Handler(void);
 void BusFault_Handler(void);
 void UsageFault_Handler(void);
@@ -59,7 +58,22 @@ void CAN1_RX0_IRQHandler(void);
 void CAN1_SCE_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void CAN1_RX1_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream3_IRQHandler(void);
+void SPI1_IRQHandler(void);
+void EXTI0_IRQHandler(void);
+void DMA1_Stream0_IRQHandler(void);
+void I2C1_EV_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+void DMA1_Stream2_IRQHandler(void);
+void UART4_IRQHandler(void);
+void TIM2_IRQHandler(void);
+void USART2_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
 
+void EXTI9_5_IRQHandler(void);
+void RTC_WKUP_IRQHandler(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
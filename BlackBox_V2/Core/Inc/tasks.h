@@ -0,0 +1,42 @@
+/*
+ * tasks.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_TASKS_H_
+#define INC_TASKS_H_
+
+#include "scheduler.h"
+
+#define TASK_MS(x) ((x) * 1000UL)
+
+/*
+ * X(id, name, body, period, first release, deadline, budget), times in us.
+ * Table order is priority order. The deadline is the latest start after a
+ * release; the dispatcher does not preempt, so it must cover the longest
+ * budget below the task plus the releases above it that can go first. The sd
+ * flush is the longest run and sets the CAN deadline. tests/test_scheduler.c
+ * runs this same table.
+ */
+#define APP_TASKS(X) \
+	X(CAN,    "can",    task_can,    TASK_MS(2),   0,           TASK_MS(5),  500)	/* 32-FRAME RING: 8 MS AT FULL 500 KBIT/S, > PERIOD + DEADLINE */ \
+	X(IMU,    "imu",    task_imu,    TASK_MS(5),   300,         TASK_MS(6),  200) \
+	X(GPS,    "gps",    task_gps,    TASK_MS(10),  600,         TASK_MS(7),  500) \
+	X(LOGGER, "logger", task_logger, TASK_MS(10),  5600,        TASK_MS(8),  500)	/* SESSION OPEN/CLOSE SYNC THE CARD AND OVERRUN */ \
+	X(SD,     "sd",     task_sd,     TASK_MS(10),  2600,        TASK_MS(5),  4000)	/* ONE SD_FLUSH_BYTES BURST: CMD25 OF 4 SECTORS PLUS A FAT UPDATE */ \
+	X(UI,     "ui",     task_ui,     TASK_MS(200), TASK_MS(50), TASK_MS(50), 1000)	/* A "prof" DUMP FORMATS ~1 KB OF TEXT */ \
+	X(HEALTH, "health", task_health, TASK_MS(100), TASK_MS(25), TASK_MS(50), 50)
+
+typedef enum {
+#define TASK_ENUM(id, name, body, period, offset, deadline, budget) TASK_##id,
+	APP_TASKS(TASK_ENUM)
+#undef TASK_ENUM
+	TASK_COUNT
+} task_id_t;
+
+extern const sched_task_t app_tasks[TASK_COUNT];
+extern uint32_t health_missed_refresh;	// HEALTH PERIODS THAT WITHHELD THE WATCHDOG REFRESH
+
+#endif /* INC_TASKS_H_ */
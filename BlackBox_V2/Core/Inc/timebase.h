@@ -0,0 +1,40 @@
+/*
+ * timebase.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_TIMEBASE_H_
+#define INC_TIMEBASE_H_
+
+#include "main.h"
+#include <stdint.h>
+
+/*
+ * Shared 1 MHz timebase on TIM2 (32-bit, free running). Wraps every ~71.6 min,
+ * so compare timestamps by unsigned difference, never by magnitude.
+ * HAL_GetTick stays the millisecond clock for timeouts.
+ */
+#define TIMEBASE_HZ 1000000UL
+
+/*
+ * GPS PPS on TIM2_CH1 (PA15, AF1). The edge is latched into CCR1 by hardware,
+ * so the capture is exact to one tick whatever the interrupt latency.
+ */
+#define PPS_GPIO_Port GPIOA
+#define PPS_Pin       GPIO_PIN_15
+
+extern volatile uint32_t timebase_pps_ts;		// TIMESTAMP OF THE LAST RISING EDGE
+extern volatile uint32_t timebase_pps_count;	// EDGES SINCE timebase_pps_init
+
+void timebase_init(void);
+void timebase_clock_update(void);	// TIM2 PRESCALER FOR THE CURRENT APB1 CLOCK, COUNT KEPT
+void timebase_pps_init(void);
+void timebase_pps_isr(void);
+
+static inline uint32_t timebase_now_us(void){
+	return TIM2->CNT;
+}
+
+#endif /* INC_TIMEBASE_H_ */
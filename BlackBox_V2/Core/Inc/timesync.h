@@ -0,0 +1,41 @@
+/*
+ * timesync.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_TIMESYNC_H_
+#define INC_TIMESYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Ties the free-running timebase to UTC. Each GPS PPS edge is captured in
+ * timebase ticks and labelled with its UTC second, taken from the time
+ * message that follows it; between messages the label is carried forward
+ * by counting whole seconds. The log stores every labelled edge, so the
+ * host can place any record in UTC by interpolating between two pulses.
+ */
+#define TIMESYNC_TOL_US      40000	// PER SECOND: HSI IS ONLY GOOD TO A FEW PERCENT OVER TEMPERATURE
+#define TIMESYNC_MAX_GAP_S   8		// LONGER PPS OUTAGES RELABEL FROM THE NEXT TIME MESSAGE
+#define TIMESYNC_DRIFT_SHIFT 3		// EMA WEIGHT 1/8 PER PULSE
+
+typedef struct {
+	bool locked;		// pps_ts CARRIES A VALID UTC LABEL
+	uint32_t pps_ts;	// TIMEBASE TICKS AT THE LAST LABELLED EDGE
+	uint32_t utc_ms;	// UTC MILLISECONDS OF DAY AT THAT EDGE (WHOLE SECONDS)
+	uint32_t date;		// DDMMYY, 0 WHILE UNKNOWN ACROSS MIDNIGHT
+	int32_t drift_ppb;	// LOCAL CLOCK RATE ERROR, POSITIVE = TIMEBASE FAST
+	uint32_t seq;		// BUMPED FOR EVERY LABELLED EDGE
+	uint32_t rejects;	// EDGE INTERVALS OUTSIDE TOLERANCE
+	uint32_t relabels;	// TIME MESSAGE DISAGREED WITH THE COUNTED LABEL
+} timesync_t;
+
+extern timesync_t timesync;
+
+void timesync_init(void);
+void timesync_update(void);
+
+#endif /* INC_TIMESYNC_H_ */
@@ -0,0 +1,66 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_TRACE_H_
+#define INC_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace_msgs.h"
+
+#define TRACE_DEBUG 0
+#define TRACE_INFO  1
+#define TRACE_WARN  2
+#define TRACE_ERROR 3
+#define TRACE_OFF   4
+
+/* Messages below this level compile out; free text (DBG_Print) is always kept */
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_DEBUG
+#endif
+
+#define TRACE_MAX_ARGS 8
+#define TRACE_TEXT_MAX 200
+
+/*
+ * Entry on the wire, little-endian:
+ *   u8 0xA5, u8 id, u8 payload length, u32 timestamp (timebase_now_us),
+ *   payload (u32 args for a table message, characters for id 0), u8 sum of id..payload
+ */
+#define TRACE_SYNC 0xA5
+#define TRACE_ID_TEXT 0
+
+typedef enum {
+	TRACE_ID_FIRST = TRACE_ID_TEXT,
+#define TRACE_ENUM(id, level, fmt) TRACE_ID_##id,
+	TRACE_MSGS(TRACE_ENUM)
+#undef TRACE_ENUM
+	TRACE_ID_COUNT
+} trace_id_t;
+
+enum {
+#define TRACE_LVL(id, level, fmt) TRACE_LVL_##id = level,
+	TRACE_MSGS(TRACE_LVL)
+#undef TRACE_LVL
+};
+
+/* TRACE(IMU_MONITOR, ts, ax, ...): arguments are stored as uint32_t, never formatted on the board */
+#define TRACE(id, ...) do { \
+	if (TRACE_LVL_##id >= TRACE_LEVEL){ \
+		const uint32_t trace_args_[] = {0, ##__VA_ARGS__}; \
+		trace_write(TRACE_ID_##id, &trace_args_[1], (sizeof(trace_args_) / sizeof(trace_args_[0])) - 1); \
+	} \
+} while (0)
+
+extern volatile uint32_t trace_dropped;	// ENTRIES LOST TO A FULL RING SINCE BOOT
+
+void trace_init(void);
+bool trace_write(trace_id_t id, const uint32_t *args, uint32_t count);	// ANY CONTEXT, NEVER BLOCKS
+bool trace_text(const char *s);
+bool trace_idle(void);
+
+#endif /* INC_TRACE_H_ */
@@ -0,0 +1,33 @@
+/*
+ * trace_msgs.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_TRACE_MSGS_H_
+#define INC_TRACE_MSGS_H_
+
+/*
+ * Trace message table: X(id, level, "printf format"). The board sends only the
+ * id and up to TRACE_MAX_ARGS 32-bit arguments; tools/trace_decode.py reads this
+ * file to format them, so ids follow table order (id 0 is free text). Append new
+ * entries at the end and keep one entry per line. Integer conversions only.
+ */
+#define TRACE_MSGS(X) \
+	X(TRACE_DROPPED,    TRACE_WARN,  "trace: %lu entries dropped (ring full)") \
+	X(BOOT_IMU,         TRACE_INFO,  "WHO_AM_I=0x%02X (want 0x68)  imu_fault=%u handshake_fault=%u") \
+	X(BOOT_IMU_OFFSETS, TRACE_INFO,  "offsets ax=%d ay=%d az=%d") \
+	X(BOOT_CAN_FILTERS, TRACE_INFO,  "CAN filter banks used: %u/%u") \
+	X(IMU_MONITOR,      TRACE_DEBUG, "t=%lu  ax=%d ay=%d az=%d  f=%u hs=%u") \
+	X(SESSION_OPEN,     TRACE_INFO,  "session %u opened, sd_fault=%u") \
+	X(SESSION_CLOSE,    TRACE_INFO,  "session closed") \
+	X(HEALTH_WITHHELD,  TRACE_WARN,  "health: watchdog refresh withheld, %lu so far") \
+	X(CLOCK_SWITCH,     TRACE_INFO,  "clock: profile %u -> %u (0 idle, 1 logging, 2 burst), HCLK %lu Hz, %lu cycles") \
+	X(LOWPOWER_CAN_WAKE, TRACE_INFO, "lowpower: CAN wake after %lu ms in STOP, back on the bus %lu us after wake") \
+	X(LOWPOWER_FIRST_FRAME, TRACE_INFO, "lowpower: first frame captured %lu us after wake, id 0x%lX") \
+	X(CRASH_BOOT,       TRACE_ERROR, "crash: reset cause %lu (0 por, 1 pin, 2 bor, 3 sw, 4 iwdg, 5 wwdg, 6 lpwr), kind %lu (0 none, 1 hardfault, 2 Error_Handler), task %lu, pc 0x%08lX, cfsr 0x%08lX") \
+	X(SESSION_ABORT,    TRACE_ERROR, "session aborted on an SD error, remounting; %lu staged bytes dropped since boot") \
+	X(CAN_LOSS,         TRACE_INFO,  "can loss since boot: fifo0 overrun=%lu full=%lu, fifo1 overrun=%lu full=%lu, ring dropped=%lu, priority ring dropped=%lu")
+
+#endif /* INC_TRACE_MSGS_H_ */
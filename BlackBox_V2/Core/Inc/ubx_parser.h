@@ -0,0 +1,88 @@
+/*
+ * ubx_parser.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#ifndef INC_UBX_PARSER_H_
+#define INC_UBX_PARSER_H_
+
+#include "gps_fix.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UBX_SYNC1 0xB5
+#define UBX_SYNC2 0x62
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+
+#define UBX_NAV_POSLLH  0x02
+#define UBX_NAV_SOL     0x06
+#define UBX_NAV_PVT     0x07	// PROTOCOL 14+ (M8 AND LATER), NAK'D BY THE NEO-6M
+#define UBX_NAV_VELNED  0x12
+#define UBX_NAV_TIMEUTC 0x21
+#define UBX_ACK_NAK     0x00
+#define UBX_ACK_ACK     0x01
+#define UBX_CFG_PRT     0x00
+#define UBX_CFG_MSG     0x01
+#define UBX_CFG_RATE    0x08
+
+/* Message bits, returned by ubx_feed when that message passed its checksum */
+#define UBX_POS     0x01	// POSITION COMMITTED (POSLLH OR PVT, WITH A FIX)
+#define UBX_VEL     0x02	// SPEED AND COURSE COMMITTED (VELNED OR PVT, WITH A FIX)
+#define UBX_STATUS  0x04	// FIX STATE UPDATED (SOL OR PVT)
+#define UBX_TIME    0x08	// UTC TIME OF DAY AND DATE UPDATED (TIMEUTC OR PVT)
+#define UBX_ACK     0x10	// ACK-ACK OR ACK-NAK, SEE ack_* FIELDS
+
+#define UBX_MAX_PAYLOAD 100	// NAV-PVT IS 92; LONGER FRAMES ARE CHECKED AND DROPPED
+#define UBX_FRAME_OVERHEAD 8	// SYNC x2, CLASS, ID, LENGTH x2, CK_A, CK_B
+
+/* One parser per byte stream, like nmea_parser_t */
+typedef struct {
+	uint8_t state;
+	uint8_t cls;
+	uint8_t id;
+	uint16_t length;
+	uint16_t index;
+	uint8_t ck_a;
+	uint8_t ck_b;
+	uint8_t payload[UBX_MAX_PAYLOAD];
+
+	/*
+	 * The NEO-6M spreads an epoch over POSLLH, SOL and VELNED. Position and
+	 * velocity are held here until the SOL of the same iTOW says the fix is good.
+	 */
+	uint32_t sol_itow;
+	bool sol_seen;
+	bool sol_ok;
+	uint32_t pos_itow;
+	bool pos_pending;
+	int32_t pos_lat_e7;
+	int32_t pos_lon_e7;
+	int32_t pos_alt_mm;
+	uint32_t vel_itow;
+	bool vel_pending;
+	int32_t vel_speed_mmps;
+	int32_t vel_course_cdeg;
+
+	/* Last acknowledgement seen */
+	uint8_t ack_cls;
+	uint8_t ack_id;
+	bool ack_ok;
+
+	uint32_t frames;		// CHECKSUM PASSED, ANY CLASS
+	uint32_t errors;		// CHECKSUM FAILURES AND OVERSIZE FRAMES
+} ubx_parser_t;
+
+void ubx_init(ubx_parser_t *p);
+
+/* Feed one byte; returns UBX_* bits for what was committed to *fix by this byte */
+uint8_t ubx_feed(ubx_parser_t *p, uint8_t c, gps_fix_t *fix);
+
+/* Frame a message into out (len + UBX_FRAME_OVERHEAD bytes); returns the frame length */
+uint16_t ubx_build(uint8_t *out, uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len);
+
+#endif /* INC_UBX_PARSER_H_ */
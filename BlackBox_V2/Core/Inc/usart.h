@@ -29,7 +29,7 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include <stdbool.h>
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart4;
@@ -39,6 +39,8 @@ extern UART_HandleTypeDef huart3;
 extern UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN Private defines */
+extern DMA_HandleTypeDef hdma_uart4_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE END Private defines */
 
@@ -49,6 +51,9 @@ void MX_USART3_UART_Init(void);
 /* TEMP: Nucleo ST-Link VCP (PA2/PA3) @ 115200 for PuTTY IMU test */
 void MX_USART2_UART_Init(void);
 void DBG_Print(const char *s);
+#define DBG_LINE_MAX 32
+void DBG_RxISR(void);
+bool DBG_ReadLine(char *out, uint32_t size);	// TRUE WITH ONE TYPED COMMAND, NO LINE ENDING
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
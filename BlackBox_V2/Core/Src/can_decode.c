@@ -0,0 +1,39 @@
+/*
+ * can_decode.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// SIGNAL DECODE FOR IDS THE FIRMWARE ACTS ON (LOGGING STAYS RAW)
+
+#include "can_decode.h"
+#include "main.h"
+
+vehicle_state_t vehicle;
+
+/* Honda ENGINE_DATA: XMISSION_SPEED 7|16@0+ (0.01,-0.5) kph, ENGINE_RPM 23|16@0+ (1,0) */
+static void decode_engine_data(const can_frame_t *frame){
+	if (frame->dlc < 4){
+		return;
+	}
+	uint16_t raw_speed = (uint16_t)((frame->data[0] << 8) | frame->data[1]);
+	vehicle.speed_ckph = (raw_speed > 50) ? (uint16_t)(raw_speed - 50) : 0; // -0.5 KPH OFFSET
+	vehicle.engine_rpm = (uint16_t)((frame->data[2] << 8) | frame->data[3]);
+	vehicle.tick = HAL_GetTick();
+	vehicle.valid = true;
+}
+
+void can_decode_frame(const can_frame_t *frame){
+	switch (frame->id){
+	case CAN_ID_ENGINE_DATA:
+		decode_engine_data(frame);
+		break;
+	default:
+		break;
+	}
+}
+
+bool vehicle_is_stationary(void){
+	return vehicle.valid && ((HAL_GetTick() - vehicle.tick) < VEHICLE_STALE_MS) && (vehicle.speed_ckph == 0);
+}
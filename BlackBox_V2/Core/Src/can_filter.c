@@ -0,0 +1,128 @@
+/*
+ * can_filter.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// HARDWARE ACCEPTANCE FILTERS: ONLY LISTED IDS COST AN INTERRUPT, A RING SLOT AND A LOG RECORD
+
+#include "can_filter.h"
+#include <stdbool.h>
+
+/* IDs we decode or analyse. Add entries here as decoders are written. */
+static const can_filter_entry_t can_filter_table[] = {
+	{ 0x158, CAN_FILTER_FIFO1 },	// ENGINE_DATA: RPM + VEHICLE SPEED, PRIORITY PATH
+	{ 0x123, CAN_FILTER_FIFO0 },	// BENCH LOOPBACK TEST FRAME SENT FROM main()
+};
+
+#define CAN_FILTER_TABLE_LEN (sizeof(can_filter_table) / sizeof(can_filter_table[0]))
+
+uint8_t can_filter_banks_used = 0;
+
+static bool can_filter_program(CAN_HandleTypeDef *hcan, CAN_FilterTypeDef *config){
+	config->SlaveStartFilterBank = CAN_FILTER_BANKS;
+	config->FilterActivation = ENABLE;
+	return HAL_CAN_ConfigFilter(hcan, config) == HAL_OK;
+}
+
+/*
+ * List banks: four IDs per 16-bit bank, two per 32-bit bank (the low half of
+ * each 32-bit register is IDE/RTR/EXID, zero for a standard data frame).
+ * Unused slots repeat the last ID.
+ */
+static bool can_filter_pack_fifo(CAN_HandleTypeDef *hcan, uint32_t fifo, uint32_t scale, uint8_t *bank){
+	int per_bank = (scale == CAN_FILTERSCALE_32BIT) ? 2 : 4;
+	uint16_t ids[4];
+	int n = 0;
+
+	for (uint32_t i = 0; i <= CAN_FILTER_TABLE_LEN; i++){
+		bool last = (i == CAN_FILTER_TABLE_LEN);
+		if (!last && (can_filter_table[i].fifo == fifo)){
+			ids[n++] = (uint16_t)((can_filter_table[i].id & 0x7FF) << 5); // STDID[10:0] IN BITS 15:5 OF EITHER SCALE
+		}
+		if ((n == per_bank) || (last && (n > 0))){
+			if (*bank >= CAN_FILTER_BANKS){
+				return false;
+			}
+			for (int k = n; k < per_bank; k++){
+				ids[k] = ids[n - 1];
+			}
+			CAN_FilterTypeDef config = {0};
+			config.FilterBank = *bank;
+			config.FilterMode = CAN_FILTERMODE_IDLIST;
+			config.FilterScale = scale;
+			if (scale == CAN_FILTERSCALE_32BIT){
+				config.FilterIdHigh = ids[0];
+				config.FilterMaskIdHigh = ids[1];
+			}
+			else{
+				config.FilterIdLow = ids[0];
+				config.FilterIdHigh = ids[1];
+				config.FilterMaskIdLow = ids[2];
+				config.FilterMaskIdHigh = ids[3];
+			}
+			config.FilterFIFOAssignment = fifo;
+			if (!can_filter_program(hcan, &config)){
+				return false;
+			}
+			(*bank)++;
+			n = 0;
+		}
+	}
+	return true;
+}
+
+/* 16-bit mask bank with both halves open (ID and mask zero): the lowest-ranked match there is */
+static bool can_filter_accept_all(CAN_HandleTypeDef *hcan, uint8_t bank){
+	CAN_FilterTypeDef config = {0};
+	config.FilterBank = bank;
+	config.FilterMode = CAN_FILTERMODE_IDMASK;
+	config.FilterScale = CAN_FILTERSCALE_16BIT;
+	config.FilterFIFOAssignment = CAN_FILTER_FIFO0;
+	return can_filter_program(hcan, &config);
+}
+
+/**
+  * @brief  Program CAN1 acceptance filters from can_filter_table
+  * @retval Number of filter banks in use. A table that does not fit falls
+  *         back to a single accept-all bank so logging never goes silent.
+  */
+uint8_t can_filter_apply(CAN_HandleTypeDef *hcan){
+	uint8_t bank = 0;
+
+	/*
+	 * bxCAN ranks matching banks by scale first (32-bit over 16-bit), then list
+	 * over mask, then bank number. The priority IDs go in 32-bit list banks so
+	 * no other bank, list or mask, can claim them for FIFO0.
+	 */
+	bool ok = can_filter_pack_fifo(hcan, CAN_FILTER_FIFO1, CAN_FILTERSCALE_32BIT, &bank) &&
+	          can_filter_pack_fifo(hcan, CAN_FILTER_FIFO0, CAN_FILTERSCALE_16BIT, &bank);
+
+#if CAN_FILTER_ACCEPT_ALL
+	/* 16-bit mask ranks below the 32-bit FIFO1 lists and, at equal scale, below the FIFO0 lists */
+	ok = ok && (bank < CAN_FILTER_BANKS) && can_filter_accept_all(hcan, bank);
+	if (ok){
+		bank++;
+	}
+#endif
+
+	if (!ok){
+		can_filter_accept_all(hcan, 0);
+		bank = 1;
+	}
+
+	/* Leftover banks from an earlier, larger table must not keep matching */
+	for (uint8_t unused = bank; unused < CAN_FILTER_BANKS; unused++){
+		CAN_FilterTypeDef config = {0};
+		config.FilterBank = unused;
+		config.FilterMode = CAN_FILTERMODE_IDLIST;
+		config.FilterScale = CAN_FILTERSCALE_16BIT;
+		config.SlaveStartFilterBank = CAN_FILTER_BANKS;
+		config.FilterActivation = DISABLE;
+		HAL_CAN_ConfigFilter(hcan, &config);
+	}
+
+	can_filter_banks_used = bank;
+	return bank;
+}
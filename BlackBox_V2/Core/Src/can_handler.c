@@ -7,71 +7,115 @@
 
 
 #include "can.h"
-#include <string.h>
-#include "can_ring_buffer.h"
+#include "can_handler.h"
+#include "can_filter.h"
+#include "timebase.h"
 #include <stdbool.h>
 #include "fault.h"
+#include "prof.h"
+#include "usart.h"
+#include <stdio.h>
 
-CAN_FilterTypeDef filter_config;
+#define CAN_NOTIFICATIONS (CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO1_MSG_PENDING | \
+                           CAN_IT_RX_FIFO0_FULL | CAN_IT_RX_FIFO1_FULL | \
+                           CAN_IT_RX_FIFO0_OVERRUN | CAN_IT_RX_FIFO1_OVERRUN | \
+                           CAN_IT_ERROR | CAN_IT_BUSOFF)
 
-volatile CAN_RxHeaderTypeDef rx_header;
-volatile uint8_t rx_data[8];
-static can_frame_t can_storage[32];
-volatile can_ring_buffer_t can_rb;
+static can_frame_t can_storage[CAN_RB_CAPACITY];
+static can_frame_t can_priority_storage[CAN_RB_PRIORITY_CAPACITY];
+can_ring_buffer_t can_rb;
+can_ring_buffer_t can_rb_priority;
+volatile can_hw_stats_t can_hw_stats;
 volatile uint32_t last_can_frame = 0;
 volatile bool can_frame_received_flag = false;
 volatile bool can_busoff_flag = false;
 
 
 void can_handler_init(void){
-	filter_config.FilterBank = 0;
-	filter_config.FilterMode = CAN_FILTERMODE_IDMASK;
-	filter_config.FilterScale = CAN_FILTERSCALE_32BIT;
-	filter_config.FilterIdHigh = 0x0000;
-	filter_config.FilterIdLow = 0x0000;
-	filter_config.FilterMaskIdHigh = 0x0000;
-	filter_config.FilterMaskIdLow = 0x0000;
-	filter_config.FilterFIFOAssignment = CAN_FILTER_FIFO0;
-	filter_config.FilterActivation = ENABLE;
-
-	HAL_CAN_ConfigFilter(&hcan1, &filter_config);
+	CANRingBuffer_Init(&can_rb, CAN_RB_CAPACITY, can_storage);
+	CANRingBuffer_Init(&can_rb_priority, CAN_RB_PRIORITY_CAPACITY, can_priority_storage);
+
+	can_filter_apply(&hcan1); // TABLE IN can_filter.c, 0x158 RPM ROUTED TO FIFO1
 	HAL_CAN_Start(&hcan1);
-	HAL_CAN_ActivateNotification(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
-	HAL_CAN_ActivateNotification(&hcan1, CAN_IT_ERROR | CAN_IT_BUSOFF); // ACTIVATING ERROR NOTIFICATION
-	CANRingBuffer_Init(&can_rb, 32, can_storage);
+	HAL_CAN_ActivateNotification(&hcan1, CAN_NOTIFICATIONS); // RX BOTH FIFOS, FIFO FULL/OVERRUN, ERRORS
 }
 
-void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan){
+/* Empty one hardware FIFO per interrupt entry; a full ring still pulls frames so the FIFO keeps draining */
+static void can_rx_drain(CAN_HandleTypeDef *hcan, uint32_t fifo, can_ring_buffer_t *rb){
+	CAN_RxHeaderTypeDef rx_header;
+	uint8_t discard[8];
+	PROF_START(CAN_RX_ISR);
 
-	if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &rx_header, (uint8_t*)rx_data) == HAL_OK) {
-		can_frame_t frame;
-		frame.id = rx_header.StdId;
-		frame.dlc = rx_header.DLC;
-		memcpy(frame.data, rx_data, sizeof(rx_data));
-		frame.timestamp = HAL_GetTick();
+	while (HAL_CAN_GetRxFifoFillLevel(hcan, fifo) > 0){
+		uint32_t stamp = timebase_now_us(); // BEFORE HAL OVERHEAD, CLOSEST TO THE FRAME
+		/* Claim first so the payload lands straight in the ring slot */
+		can_frame_t *slot = CANRingBuffer_Claim(rb);
+		if (HAL_CAN_GetRxMessage(hcan, fifo, &rx_header, (slot != NULL) ? slot->data : discard) != HAL_OK){
+			break;
+		}
 		last_can_frame = HAL_GetTick();
 		can_frame_received_flag = true;
-		CANRingBuffer_Push(&can_rb, frame);
+		if (slot != NULL){
+			slot->id = rx_header.StdId;
+			slot->dlc = rx_header.DLC;
+			slot->timestamp = stamp;
+			CANRingBuffer_Commit(rb);
+		}
 	}
+	PROF_STOP(CAN_RX_ISR);
+}
+
+void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan){
+	can_rx_drain(hcan, CAN_RX_FIFO0, &can_rb);
+}
+
+void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan){
+	can_rx_drain(hcan, CAN_RX_FIFO1, &can_rb_priority);
+}
+
+void HAL_CAN_RxFifo0FullCallback(CAN_HandleTypeDef *hcan){
+	can_hw_stats.fifo0_full++;
+	can_rx_drain(hcan, CAN_RX_FIFO0, &can_rb);
+}
+
+void HAL_CAN_RxFifo1FullCallback(CAN_HandleTypeDef *hcan){
+	can_hw_stats.fifo1_full++;
+	can_rx_drain(hcan, CAN_RX_FIFO1, &can_rb_priority);
 }
 
 void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan){
 	uint32_t error_code = HAL_CAN_GetError(hcan);
+	if (error_code & HAL_CAN_ERROR_RX_FOV0){
+		can_hw_stats.fifo0_overrun++;
+	}
+	if (error_code & HAL_CAN_ERROR_RX_FOV1){
+		can_hw_stats.fifo1_overrun++;
+	}
 	if (error_code & HAL_CAN_ERROR_BOF){
 		can_busoff_flag = true;
 		fault_flags.can_fault = true;
 	}
+	HAL_CAN_ResetError(hcan); // ERROR CODE ACCUMULATES, CLEAR SO EACH EVENT COUNTS ONCE
 }
 void CAN_Handler_RecoverBusOff(void){
 	if (can_busoff_flag){
 		HAL_CAN_Stop(&hcan1);                              // parameter: CAN handle
 		HAL_CAN_Init(&hcan1);                              // parameter: CAN handle - reinitializes, clears bus-off
-		HAL_CAN_ConfigFilter(&hcan1, &filter_config);       // REAPPLY FILTER
+		can_filter_apply(&hcan1);                           // REAPPLY FILTER
 		HAL_CAN_Start(&hcan1);                              // parameter: CAN handle
-		HAL_CAN_ActivateNotification(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_ERROR | CAN_IT_BUSOFF); // re-activate both
+		HAL_CAN_ActivateNotification(&hcan1, CAN_NOTIFICATIONS); // re-activate all
 		fault_flags.can_fault = false;
 		can_busoff_flag = false; 							// CLEAR FLAGS
 	}
 
 }
 
+/* Frames lost before the logger saw them: in the bxCAN FIFOs, then in the two rings */
+void can_handler_dump(void){
+	char line[160];
+	snprintf(line, sizeof(line), "can loss since boot: fifo0 overrun=%lu full=%lu, fifo1 overrun=%lu full=%lu, ring dropped=%lu, priority ring dropped=%lu\r\n",
+	         (unsigned long)can_hw_stats.fifo0_overrun, (unsigned long)can_hw_stats.fifo0_full,
+	         (unsigned long)can_hw_stats.fifo1_overrun, (unsigned long)can_hw_stats.fifo1_full,
+	         (unsigned long)can_rb.dropped_count, (unsigned long)can_rb_priority.dropped_count);
+	DBG_Print(line);
+}
@@ -6,39 +6,75 @@
  */
 
 // SECONDARY RING BUFFER WRITTEN TO PERMIT USABILITY FOR LARGER SIZED CAN FRAMES
-// LOGIC REMAINS SAME
+// LOCK-FREE SPSC: NO SHARED COUNT, EACH SIDE OWNS ONE INDEX
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
+#include "main.h"
 #include "can_ring_buffer.h"
 
 
-void CANRingBuffer_Init(volatile can_ring_buffer_t *rb, uint16_t capacity, can_frame_t *buffer){
+bool CANRingBuffer_Init(can_ring_buffer_t *rb, uint32_t capacity, can_frame_t *buffer){
+	if ((capacity == 0) || ((capacity & (capacity - 1)) != 0)){
+		return false; // MASK WRAP NEEDS A POWER OF TWO
+	}
 	rb->head = 0;
 	rb->tail = 0;
-	rb->count = 0;
 	rb->dropped_count = 0;
 	rb->buffer = buffer;
-	rb->capacity = capacity;
+	rb->mask = capacity - 1;
+	return true;
 }
-bool CANRingBuffer_Push(volatile can_ring_buffer_t *rb, can_frame_t data){
-	rb -> buffer[rb->head] = data;
-	rb->head = (rb->head + 1) % rb->capacity;
-	if (rb->count == rb->capacity){
-		rb -> tail = (rb -> tail + 1) % rb->capacity;
+
+can_frame_t *CANRingBuffer_Claim(can_ring_buffer_t *rb){
+	uint32_t head = rb->head;
+	if ((head - rb->tail) > rb->mask){
 		rb->dropped_count++;
+		return NULL;
 	}
-	else{
-		rb->count++;
+	return &rb->buffer[head & rb->mask];
+}
+
+void CANRingBuffer_Commit(can_ring_buffer_t *rb){
+	__DMB(); // SLOT CONTENTS VISIBLE BEFORE THE NEW HEAD
+	rb->head = rb->head + 1;
+}
+
+bool CANRingBuffer_Push(can_ring_buffer_t *rb, const can_frame_t *data){
+	can_frame_t *slot = CANRingBuffer_Claim(rb);
+	if (slot == NULL){
+		return false;
 	}
+	*slot = *data;
+	CANRingBuffer_Commit(rb);
 	return true;
 }
-bool CANRingBuffer_Pop(volatile can_ring_buffer_t *rb, can_frame_t *data_out){
-	if (rb->count == 0){
+
+const can_frame_t *CANRingBuffer_Peek(can_ring_buffer_t *rb){
+	uint32_t tail = rb->tail;
+	if (rb->head == tail){
+		return NULL;
+	}
+	__DMB(); // HEAD READ BEFORE THE SLOT IT PUBLISHES
+	return &rb->buffer[tail & rb->mask];
+}
+
+void CANRingBuffer_Release(can_ring_buffer_t *rb){
+	__DMB(); // FINISH READING THE SLOT BEFORE HANDING IT BACK
+	rb->tail = rb->tail + 1;
+}
+
+bool CANRingBuffer_Pop(can_ring_buffer_t *rb, can_frame_t *data_out){
+	const can_frame_t *slot = CANRingBuffer_Peek(rb);
+	if (slot == NULL){
 		return false;
 	}
-	*data_out = rb->buffer[rb->tail];
-	rb -> tail = (rb->tail + 1) % rb->capacity;
-	rb -> count--;
+	*data_out = *slot;
+	CANRingBuffer_Release(rb);
 	return true;
 }
+
+uint32_t CANRingBuffer_Count(const can_ring_buffer_t *rb){
+	return rb->head - rb->tail;
+}
@@ -0,0 +1,248 @@
+/*
+ * clock_profile.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// RUNTIME CLOCK PROFILES: AHB/APB PRESCALER SWITCHING, PERIPHERAL RETUNING, RESIDENCY STATS
+
+#include "clock_profile.h"
+#include "main.h"
+#include "timebase.h"
+#include "scheduler.h"
+#include "can_handler.h"
+#include "fatfs.h"
+#include "usart.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CLOCK_PLL_HZ 180000000UL	// SYSCLK, FIXED BY SystemClock_Config
+
+typedef struct {
+	const char *name;
+	uint32_t hpre;		// RCC_SYSCLK_DIVx
+	uint32_t ppre1;		// RCC_HCLK_DIVx
+	uint32_t ppre2;		// RCC_HCLK_DIVx
+	uint32_t latency;	// FLASH_LATENCY_x FOR HCLK AT 2.7-3.6 V
+} clock_profile_cfg_t;
+
+/* HCLK / PCLK1 / PCLK2 (TIM2) in MHz */
+static const clock_profile_cfg_t clock_profiles[CLOCK_PROFILE_COUNT] = {
+	[CLOCK_IDLE]    = {"idle",    RCC_SYSCLK_DIV4, RCC_HCLK_DIV1, RCC_HCLK_DIV1, FLASH_LATENCY_1},	// 45/45/45 (45)
+	[CLOCK_LOGGING] = {"logging", RCC_SYSCLK_DIV2, RCC_HCLK_DIV2, RCC_HCLK_DIV1, FLASH_LATENCY_2},	// 90/45/90 (90)
+	[CLOCK_BURST]   = {"burst",   RCC_SYSCLK_DIV1, RCC_HCLK_DIV4, RCC_HCLK_DIV2, FLASH_LATENCY_5},	// 180/45/90 (90)
+};
+
+static clock_profile_t clock_current = CLOCK_LOGGING;
+static clock_profile_stats_t clock_stats[CLOCK_PROFILE_COUNT];
+static uint32_t clock_since_us = 0;		// TIMEBASE AT THE LAST ACCOUNTING
+static uint32_t clock_frames_mark = 0;	// CAN FRAME COUNT AT THE LAST ACCOUNTING
+
+/* Burst hysteresis, HAL_GetTick based */
+static bool clock_load_high = false;
+static uint32_t clock_quiet_since = 0;
+static uint32_t clock_window_start = 0;
+static uint32_t clock_window_frames = 0;
+
+/* Frames the controller handed over, admitted or dropped by the rings */
+static uint32_t clock_can_frames(void){
+	return can_rb.head + can_rb.dropped_count + can_rb_priority.head + can_rb_priority.dropped_count;
+}
+
+uint32_t clock_profile_hclk(clock_profile_t p){
+	return CLOCK_PLL_HZ >> AHBPrescTable[(clock_profiles[p].hpre & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+}
+
+static uint32_t clock_profile_pclk1(clock_profile_t p){
+	return clock_profile_hclk(p) >> APBPrescTable[(clock_profiles[p].ppre1 & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+/* Charge the time and frames since the last call to the running profile */
+static void clock_account(void){
+	uint32_t now = timebase_now_us();
+	uint32_t frames = clock_can_frames();
+	clock_stats[clock_current].time_us += now - clock_since_us;
+	clock_stats[clock_current].frames += frames - clock_frames_mark;
+	clock_since_us = now;
+	clock_frames_mark = frames;
+}
+
+void clock_profile_init(void){
+	/* PCLK1 consumers are never retuned; a table edit that moves it must not boot */
+	for (int p = 0; p < CLOCK_PROFILE_COUNT; p++){
+		if (clock_profile_pclk1((clock_profile_t)p) != HAL_RCC_GetPCLK1Freq()){
+			Error_Handler();
+		}
+	}
+	memset(clock_stats, 0, sizeof(clock_stats));
+	clock_current = CLOCK_LOGGING; // SystemClock_Config LEAVES THE LOGGING PRESCALERS
+	clock_stats[clock_current].entries = 1;
+	clock_since_us = timebase_now_us();
+	clock_frames_mark = clock_can_frames();
+	clock_load_high = false;
+	clock_window_start = HAL_GetTick();
+	clock_window_frames = clock_frames_mark;
+}
+
+bool clock_profile_set(clock_profile_t p){
+	if (p >= CLOCK_PROFILE_COUNT){
+		return false;
+	}
+	if (p == clock_current){
+		return true;
+	}
+	const clock_profile_cfg_t *to = &clock_profiles[p];
+	clock_profile_t from = clock_current;
+	uint32_t pclk2_before = HAL_RCC_GetPCLK2Freq();
+	bool faster = clock_profile_hclk(p) > SystemCoreClock;
+
+	clock_account();
+	uint32_t start = DWT->CYCCNT;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	/*
+	 * Wait states go up before HCLK does and down after. Of HPRE and the APB
+	 * dividers, whichever lowers PCLK is written first, so for the few AHB
+	 * cycles between the two writes PCLK1 dips below 45 MHz, never above.
+	 */
+	if (faster){
+		__HAL_FLASH_SET_LATENCY(to->latency);
+		(void)__HAL_FLASH_GET_LATENCY(); // TAKES EFFECT ONCE READ BACK
+		MODIFY_REG(RCC->CFGR, RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2, to->ppre1 | (to->ppre2 << 3));
+		MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, to->hpre);
+	}
+	else{
+		MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, to->hpre);
+		MODIFY_REG(RCC->CFGR, RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2, to->ppre1 | (to->ppre2 << 3));
+		__HAL_FLASH_SET_LATENCY(to->latency);
+		(void)__HAL_FLASH_GET_LATENCY();
+	}
+	SystemCoreClockUpdate();
+	HAL_InitTick(uwTickPrio); // RESTARTS THE CURRENT MILLISECOND
+	timebase_clock_update();
+	__set_PRIMASK(primask);
+
+	/* SPI1 is only driven from task context, so it is idle here */
+	if (HAL_RCC_GetPCLK2Freq() != pclk2_before){
+		SD_SPI_ClockUpdate();
+	}
+	scheduler_clock_update();
+
+	uint32_t cycles = DWT->CYCCNT - start;
+	clock_current = p;
+	clock_stats[p].entries++;
+	if (cycles > clock_stats[p].switch_max_cycles){
+		clock_stats[p].switch_max_cycles = cycles;
+	}
+	TRACE(CLOCK_SWITCH, from, p, SystemCoreClock, cycles);
+	return true;
+}
+
+/*
+ * After STOP the core runs on HSI with the PLL off and over-drive dropped. The
+ * prescalers and wait states survive, so the running profile comes back by
+ * relocking the PLL and selecting it. Called with interrupts masked straight
+ * after WFI, so the ready-waits have no tick to time out on; the IWDG backs
+ * them up. Returns the microseconds since wake_cycles (DWT at the first
+ * instruction after WFI), counted at the HSI rate.
+ */
+uint32_t clock_profile_resume(uint32_t wake_cycles){
+	uint32_t hsi_mhz = (HSI_VALUE >> AHBPrescTable[(RCC->CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos]) / 1000000U;
+
+	__HAL_RCC_PLL_ENABLE();
+	while (__HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY) == RESET){
+	}
+	if (HAL_PWREx_EnableOverDrive() != HAL_OK){
+		Error_Handler();
+	}
+	__HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+	while (__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK){
+	}
+	uint32_t cycles = DWT->CYCCNT - wake_cycles;
+
+	SystemCoreClockUpdate();
+	HAL_InitTick(uwTickPrio);
+	return cycles / ((hsi_mhz != 0) ? hsi_mhz : 1U);
+}
+
+/* Enter on a high frame rate or a half-full ring; leave once the rate has stayed low for the hold */
+static bool clock_burst_wanted(void){
+	uint32_t now = HAL_GetTick();
+
+	if (CANRingBuffer_Count(&can_rb) * CLOCK_BURST_ENTER_FILL >= CAN_RB_CAPACITY){
+		clock_load_high = true;
+		clock_quiet_since = now;
+	}
+	uint32_t elapsed = now - clock_window_start;
+	if (elapsed >= CLOCK_LOAD_WINDOW_MS){
+		uint32_t frames = clock_can_frames();
+		uint32_t fps = (frames - clock_window_frames) * 1000U / elapsed;
+		clock_window_start = now;
+		clock_window_frames = frames;
+		if (fps >= CLOCK_BURST_ENTER_FPS){
+			clock_load_high = true;
+		}
+		if (fps >= CLOCK_BURST_EXIT_FPS){
+			clock_quiet_since = now;
+		}
+	}
+	if (clock_load_high && ((now - clock_quiet_since) >= CLOCK_BURST_HOLD_MS)){
+		clock_load_high = false;
+	}
+	return clock_load_high;
+}
+
+void clock_profile_update(sys_state_t state){
+	clock_profile_t want;
+
+	clock_account();
+	switch (state){
+	case SYS_IDLE:
+		want = CLOCK_IDLE;
+		break;
+	case SYS_LOGGING:
+		want = clock_burst_wanted() ? CLOCK_BURST : CLOCK_LOGGING;
+		break;
+	default: // INIT, FAULT RECOVERY AND SHUTDOWN'S CLOSE RUN AT THE BOOT CLOCK
+		want = CLOCK_LOGGING;
+		break;
+	}
+	if (state != SYS_LOGGING){
+		clock_load_high = false;
+	}
+	clock_profile_set(want);
+}
+
+clock_profile_t clock_profile_current(void){
+	return clock_current;
+}
+
+const char *clock_profile_name(clock_profile_t p){
+	return clock_profiles[p].name;
+}
+
+void clock_profile_stats(clock_profile_t p, clock_profile_stats_t *out){
+	clock_account();
+	*out = clock_stats[p];
+}
+
+void clock_profile_dump(void){
+	char line[128];
+	snprintf(line, sizeof(line), "---- clock: %s, HCLK %lu MHz, since boot ----\r\n",
+	         clock_profile_name(clock_current), (unsigned long)(SystemCoreClock / 1000000U));
+	DBG_Print(line);
+	for (int i = 0; i < CLOCK_PROFILE_COUNT; i++){
+		clock_profile_stats_t s;
+		clock_profile_stats((clock_profile_t)i, &s);
+		uint32_t ms = (uint32_t)(s.time_us / 1000U);
+		uint32_t fps = (ms != 0) ? (uint32_t)((uint64_t)s.frames * 1000U / ms) : 0;
+		snprintf(line, sizeof(line), "%-8s %3lu MHz in=%lu t=%lu ms frames=%lu (%lu/s) switch max=%lu us\r\n",
+		         clock_profiles[i].name, (unsigned long)(clock_profile_hclk((clock_profile_t)i) / 1000000U),
+		         (unsigned long)s.entries, (unsigned long)ms, (unsigned long)s.frames, (unsigned long)fps,
+		         (unsigned long)(s.switch_max_cycles / (clock_profile_hclk((clock_profile_t)i) / 1000000U)));
+		DBG_Print(line);
+	}
+}
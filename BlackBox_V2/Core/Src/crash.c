@@ -0,0 +1,176 @@
+/*
+ * crash.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// POST-MORTEM: BACKUP SRAM RECORD, HARDFAULT CAPTURE, RESET-CAUSE DECODING
+
+#include "crash.h"
+#include "can_handler.h"
+#include "sd_logger.h"
+#include "trace.h"
+#include <string.h>
+
+extern uint8_t _estack; /* Symbol defined in the linker script */
+
+static reset_cause_t crash_cause = RESET_POWER_ON;
+static crash_record_t crash_last;		// THE PREVIOUS RUN'S RECORD, TAKEN AT BOOT
+static bool crash_unlogged = false;
+
+/* Idempotent; the fault path cannot assume crash_init ran */
+static void crash_bkp_enable(void){
+	__HAL_RCC_PWR_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+	__HAL_RCC_BKPSRAM_CLK_ENABLE();
+}
+
+/* PINRSTF is set on every internal reset as well, so it is the fallback; BORRSTF also comes with a POR */
+static reset_cause_t crash_decode(uint32_t csr){
+	if (csr & RCC_CSR_LPWRRSTF){
+		return RESET_LOW_POWER;
+	}
+	if (csr & RCC_CSR_WWDGRSTF){
+		return RESET_WWDG;
+	}
+	if (csr & RCC_CSR_IWDGRSTF){
+		return RESET_IWDG;
+	}
+	if (csr & RCC_CSR_SFTRSTF){
+		return RESET_SOFTWARE;
+	}
+	if (csr & RCC_CSR_PORRSTF){
+		return RESET_POWER_ON;
+	}
+	if (csr & RCC_CSR_BORRSTF){
+		return RESET_BROWNOUT;
+	}
+	return RESET_PIN;
+}
+
+void crash_init(void){
+	crash_bkp_enable();
+	crash_cause = crash_decode(RCC->CSR);
+	__HAL_RCC_CLEAR_RESET_FLAGS();
+
+	volatile crash_record_t *bkp = CRASH_BKP;
+	if (bkp->magic == CRASH_MAGIC){
+		memcpy(&crash_last, (const void *)bkp, sizeof(crash_last));
+		crash_last.held = 1;
+	}
+	else{
+		memset(&crash_last, 0, sizeof(crash_last)); // POWERED DOWN: CAUSE ONLY
+		crash_last.task = CRASH_NO_TASK;
+	}
+
+	/* A power-on or a reset button is a normal start; anything else is logged */
+	crash_unlogged = (crash_last.kind != CRASH_NONE) ||
+	                 ((crash_cause != RESET_POWER_ON) && (crash_cause != RESET_PIN));
+
+	memset((void *)bkp, 0, sizeof(crash_record_t));
+	bkp->task = CRASH_NO_TASK;
+	bkp->state = (uint8_t)current_state;
+	bkp->magic = CRASH_MAGIC;
+
+	if (crash_unlogged){
+		TRACE(CRASH_BOOT, crash_cause, crash_last.kind, crash_last.task, crash_last.r[6], crash_last.cfsr);
+	}
+}
+
+/* Everything but the fault registers; the IWDG gives no chance to take more */
+static void crash_capture(volatile crash_record_t *rec){
+	rec->state = (uint8_t)current_state;
+	rec->uptime_ms = HAL_GetTick();
+	rec->can_head = can_rb.head;
+	rec->can_tail = can_rb.tail;
+	rec->can_dropped = can_rb.dropped_count;
+	rec->prio_head = can_rb_priority.head;
+	rec->prio_tail = can_rb_priority.tail;
+	rec->prio_dropped = can_rb_priority.dropped_count;
+	rec->staged = SD_Logger_Staged();
+}
+
+void crash_checkpoint(void){
+	crash_capture(CRASH_BKP);
+}
+
+static void crash_fault_regs(volatile crash_record_t *rec){
+	rec->cfsr = SCB->CFSR;
+	rec->hfsr = SCB->HFSR;
+	rec->mmfar = SCB->MMFAR;
+	rec->bfar = SCB->BFAR;
+}
+
+/* Reset rather than spin: the log resumes in ~100 ms instead of after the ~8 s IWDG timeout */
+static void crash_reset(void) __attribute__((noreturn));
+static void crash_reset(void){
+	__DSB();
+	NVIC_SystemReset();
+}
+
+/* Entered from HardFault_Handler with the exception frame and EXC_RETURN */
+void crash_hardfault(const uint32_t *frame, uint32_t exc_return) __attribute__((used, noreturn));
+void crash_hardfault(const uint32_t *frame, uint32_t exc_return){
+	crash_bkp_enable();
+	volatile crash_record_t *rec = CRASH_BKP;
+	uint32_t sp = (uint32_t)frame;
+
+	rec->magic = CRASH_MAGIC;
+	rec->kind = CRASH_HARDFAULT;
+	rec->exc_return = exc_return;
+	rec->sp = sp;
+	for (int i = 0; i < 8; i++){
+		/* An overflowed stack may not hold a frame; leave the registers zero rather than fault again */
+		rec->r[i] = ((sp >= SRAM1_BASE) && (sp + 32U <= (uint32_t)&_estack)) ? frame[i] : 0U;
+	}
+	crash_fault_regs(rec);
+	crash_capture(rec);
+	crash_reset();
+}
+
+/*
+ * Naked so the stack is exactly as the exception left it: bit 2 of EXC_RETURN
+ * says which stack holds the frame.
+ */
+__attribute__((naked)) void HardFault_Handler(void){
+	__asm volatile(
+		"tst lr, #4         \n"
+		"ite eq             \n"
+		"mrseq r0, msp      \n"
+		"mrsne r0, psp      \n"
+		"mov r1, lr         \n"
+		"b crash_hardfault  \n"
+	);
+}
+
+void crash_error_handler(uint32_t caller){
+	__disable_irq();
+	crash_bkp_enable();
+	volatile crash_record_t *rec = CRASH_BKP;
+
+	rec->magic = CRASH_MAGIC;
+	rec->kind = CRASH_ERROR_HANDLER;
+	for (int i = 0; i < 8; i++){
+		rec->r[i] = 0;
+	}
+	rec->r[6] = caller;
+	rec->exc_return = 0;
+	rec->sp = __get_MSP();
+	crash_fault_regs(rec);
+	crash_capture(rec);
+	crash_reset();
+}
+
+reset_cause_t crash_reset_cause(void){
+	return crash_cause;
+}
+
+bool crash_pending(const crash_record_t **out){
+	*out = &crash_last;
+	return crash_unlogged;
+}
+
+void crash_logged(void){
+	crash_unlogged = false;
+}
@@ -0,0 +1,188 @@
+/*
+ * dead_reckon.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// FIXED-POINT DEAD RECKONING BETWEEN GPS FIXES: SPEED x HEADING, SNAPPED TO EACH FIX
+
+#include "dead_reckon.h"
+#include "main.h"
+#include "geo.h"
+#include "gps_driver.h"
+#include "can_decode.h"
+#include "timebase.h"
+#include <string.h>
+
+#define DR_OUT_PERIOD_US   (1000000UL / DR_OUT_HZ)
+#define GPS_SPEED_STALE_US 2000000UL
+
+/* Heading is a 32-bit binary angle: 2^32 = 360 deg, so it wraps for free */
+#define CDEG_TO_BAM(c)     ((uint32_t)(((uint64_t)(c) << 32) / 36000U))
+#define BAM_TO_CDEG(b)     ((uint16_t)(((uint64_t)(b) * 36000U) >> 32))
+
+/* Gyro at +-250 dps is 131 counts per deg/s: BAM per count-microsecond, q16 = 2^48 / (360 * 131 * 1e6) */
+#define GYRO_BAM_Q16       5969
+
+/* ay counts to the equivalent gyro counts at speed v: 9806.65 / 16384 * 57.2958 * 131, per mm/s */
+#define ACCEL_YAW_NUM      4493
+
+dead_reckon_t dead_reckon;
+
+static bool dr_anchored = false;
+static bool dr_heading_known = false;
+static int32_t dr_anchor_lat = 0;
+static int32_t dr_anchor_lon = 0;
+static int32_t dr_north_q8 = 0;	// OFFSET FROM THE ANCHOR, 1/256 MM
+static int32_t dr_east_q8 = 0;
+static uint32_t dr_heading = 0;	// BAM
+static uint32_t dr_fix_tick = 0;
+static uint32_t dr_emit_ts = 0;
+static bool dr_stepped = false;
+
+void dead_reckon_reset(void){
+	memset(&dead_reckon, 0, sizeof(dead_reckon));
+	dr_anchored = false;
+	dr_heading_known = false;
+	dr_stepped = false;
+	dr_north_q8 = 0;
+	dr_east_q8 = 0;
+}
+
+/* CAN wheel speed while the bus is alive, else the last GPS ground speed */
+static int32_t dr_speed_mmps(void){
+	if (vehicle.valid && ((HAL_GetTick() - vehicle.tick) < VEHICLE_STALE_MS)){
+		return (int32_t)(((uint32_t)vehicle.speed_ckph * 25U) / 9U); // 0.01 KPH = 25/9 MM/S
+	}
+	if (gps.locked && ((timebase_now_us() - gps.timestamp) < GPS_SPEED_STALE_US)){
+		return gps.speed_mmps;
+	}
+	return 0;
+}
+
+static int32_t dr_yaw_counts(const imu_frame *sample, int32_t speed){
+#if DR_YAW_FROM_ACCEL
+	if (speed < DR_COURSE_MIN_MMPS){
+		return 0; // a / v BLOWS UP NEAR STANDSTILL
+	}
+	return ((int32_t)sample->accel_y * ACCEL_YAW_NUM) / speed;
+#else
+	(void)speed;
+	return sample->gyro_z;
+#endif
+}
+
+void dead_reckon_step(const imu_frame *sample){
+	if (!dr_stepped){
+		dead_reckon.timestamp = sample->timestamp;
+		dr_emit_ts = sample->timestamp;
+		dr_stepped = true;
+		return;
+	}
+	int32_t dt = (int32_t)(sample->timestamp - dead_reckon.timestamp);
+	dead_reckon.timestamp = sample->timestamp;
+	if (dt <= 0){
+		return;
+	}
+	if (dt > DR_MAX_STEP_US){
+		dt = DR_MAX_STEP_US;
+	}
+
+	int32_t speed = dr_speed_mmps();
+	dead_reckon.speed_mmps = speed;
+
+	int64_t yaw = (int64_t)dr_yaw_counts(sample, speed) * dt * GYRO_BAM_Q16;
+	dr_heading += (uint32_t)(int32_t)((DR_YAW_SIGN * yaw) / 65536);
+	dead_reckon.heading_cdeg = BAM_TO_CDEG(dr_heading);
+
+	if (!dr_anchored || (speed == 0) || ((HAL_GetTick() - dr_fix_tick) >= DR_MAX_COAST_MS)){
+		return; // NOTHING TO MOVE, OR COASTED TOO LONG: THE NEXT FIX RE-ANCHORS
+	}
+	int32_t s, c;
+	int32_t step_q8 = (int32_t)(((int64_t)speed * dt * 256) / 1000000); // DISTANCE THIS STEP
+	geo_sin_cos_q15(dead_reckon.heading_cdeg, &s, &c);
+	dr_north_q8 += (int32_t)(((int64_t)step_q8 * c) / 32768);
+	dr_east_q8 += (int32_t)(((int64_t)step_q8 * s) / 32768);
+}
+
+static void dr_position(int32_t *lat, int32_t *lon){
+	*lat = dr_anchor_lat;
+	*lon = dr_anchor_lon;
+	geo_offset(lat, lon, dr_north_q8 / 256, dr_east_q8 / 256);
+}
+
+static void dr_anchor(void){
+	dr_anchor_lat = gps.lat_e7;
+	dr_anchor_lon = gps.lon_e7;
+	dr_north_q8 = 0;
+	dr_east_q8 = 0;
+	dr_anchored = true;
+}
+
+void dead_reckon_fix(void){
+	if (!gps.locked){
+		return;
+	}
+	bool fresh = dr_anchored && ((HAL_GetTick() - dr_fix_tick) < DR_MAX_COAST_MS);
+	dr_fix_tick = HAL_GetTick();
+
+	/* Heading: adopt the GPS course outright the first time, then nudge towards it */
+	if (gps.speed_mmps >= DR_COURSE_MIN_MMPS){
+		uint32_t course = CDEG_TO_BAM((uint32_t)gps.course_cdeg % 36000U);
+		if (!dr_heading_known || !fresh){
+			dr_heading = course;
+			dr_heading_known = true;
+		}
+		else{
+			int32_t err = (int32_t)(course - dr_heading) / 4; // SIGNED BAM DIFFERENCE IS THE SHORT WAY ROUND
+			int32_t limit = (int32_t)CDEG_TO_BAM(DR_HEADING_SNAP_CDEG);
+			if (err > limit) err = limit;
+			if (err < -limit) err = -limit;
+			dr_heading += (uint32_t)err;
+		}
+	}
+
+	if (!fresh){
+		dr_anchor();
+		return;
+	}
+
+	int32_t lat, lon, n, e;
+	dr_position(&lat, &lon);
+	geo_delta_mm(lat, lon, gps.lat_e7, gps.lon_e7, &n, &e);
+	uint32_t err = geo_distance_mm(lat, lon, gps.lat_e7, gps.lon_e7);
+	dead_reckon.last_error_mm = err;
+	if (err > DR_RESET_MM){
+		dead_reckon.resets++;
+		dr_anchor();
+		return;
+	}
+
+	/* Move at most DR_SNAP_MAX_MM towards the fix; a glitching fix cannot drag the track far */
+	int32_t corr_n = n;
+	int32_t corr_e = e;
+	if (err > DR_SNAP_MAX_MM){
+		corr_n = (int32_t)(((int64_t)n * DR_SNAP_MAX_MM) / err);
+		corr_e = (int32_t)(((int64_t)e * DR_SNAP_MAX_MM) / err);
+	}
+	dead_reckon.snaps++;
+
+	/* Re-anchor on the fix, keeping whatever part of the error was not corrected */
+	dr_anchor();
+	dr_north_q8 = (corr_n - n) * 256;
+	dr_east_q8 = (corr_e - e) * 256;
+}
+
+bool dead_reckon_emit(void){
+	dead_reckon.valid = dr_anchored && dr_heading_known && ((HAL_GetTick() - dr_fix_tick) < DR_MAX_COAST_MS);
+	if (!dead_reckon.valid || ((dead_reckon.timestamp - dr_emit_ts) < DR_OUT_PERIOD_US)){
+		return false;
+	}
+	dr_emit_ts += DR_OUT_PERIOD_US;
+	if ((dead_reckon.timestamp - dr_emit_ts) >= DR_OUT_PERIOD_US){
+		dr_emit_ts = dead_reckon.timestamp; // FELL BEHIND (GAP IN THE STREAM): RESTART THE GRID
+	}
+	dr_position(&dead_reckon.lat_e7, &dead_reckon.lon_e7);
+	return true;
+}
@@ -0,0 +1,33 @@
+/*
+ * dma_streams.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// DMA CONTROLLER CLOCKS AND STREAM IRQS FOR THE HAND-LINKED PERIPHERAL STREAMS
+
+#include "dma_streams.h"
+#include "main.h"
+
+/*
+ * BlackBox_V2.ioc carries no DMA requests, so CubeMX neither generates nor
+ * keeps a dma.c; the streams are set up here instead. Each handle is filled in
+ * and linked in its peripheral's MspInit USER CODE block, and each IRQ handler
+ * sits in USER CODE 1 of stm32f4xx_it.c. A stream added there needs its line here.
+ */
+void dma_streams_init(void){
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, 2, 0); // I2C1_RX, MPU6050 BURST READS
+	HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Stream2_IRQn, 3, 0); // UART4_RX, GPS CIRCULAR RING
+	HAL_NVIC_EnableIRQ(DMA1_Stream2_IRQn);
+	HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 3, 0); // USART2_TX, TRACE OUTPUT
+	HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 1, 0); // SPI1_RX, SD SECTOR DATA
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+	HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, 1, 0); // SPI1_TX, SD SECTOR DATA
+	HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+}
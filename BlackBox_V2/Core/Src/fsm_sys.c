@@ -13,7 +13,6 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "main.h"
-#include "imu.h"
 
 #define IDLE_SHUTDOWN_TIMEOUT_MS 300000
 // VARIABLE DECLARATION
@@ -38,7 +37,6 @@ void SYS_FSM_TICK(void){
 
     break;
     case SYS_IDLE:
-        imu_read();
         if (can_frame_received_flag){
             current_state = SYS_LOGGING;
             start_new_session_file();
@@ -52,7 +50,11 @@ void SYS_FSM_TICK(void){
         }
         break;
     case SYS_LOGGING:
-        if (can_frame_received_flag){
+        if (fault_flags.sd_fault){ // FAILED WRITE OR BUSY TIMEOUT: STOP WRITING AND LET sd_recovery REMOUNT
+            abort_session_file();
+            current_state = SYS_FAULT;
+        }
+        else if (can_frame_received_flag){
             last_can_frame = HAL_GetTick();
             can_frame_received_flag = false;
         }
@@ -63,8 +65,6 @@ void SYS_FSM_TICK(void){
                 current_state = SYS_IDLE;
             }
         }
-        SD_Logger_DrainCAN(); // DRAIN CAN RB FROM HERE
-        imu_read(); // READ IMU DATA
         break;
 
     case SYS_FAULT: // MIGHT WANT TO ADD SOMETHING HERE FOR CAN LATER ON
@@ -0,0 +1,172 @@
+/*
+ * geo.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// INTEGER GEODESY: FLAT-EARTH DISTANCE, CORDIC HEADING, NO FLOAT
+
+#include "geo.h"
+
+#define E7_PER_DEG  10000000L
+#define E7_180      (180L * E7_PER_DEG)
+#define CORDIC_ITER 16
+
+/* cos(0..90 deg) in q15, 1 deg steps */
+static const int16_t cos_q15_tab[91] = {
+	32767, 32763, 32748, 32723, 32688, 32643, 32588, 32524, 32449, 32365,
+	32270, 32166, 32052, 31928, 31795, 31651, 31499, 31336, 31164, 30983,
+	30792, 30592, 30382, 30163, 29935, 29698, 29452, 29197, 28932, 28660,
+	28378, 28088, 27789, 27482, 27166, 26842, 26510, 26170, 25822, 25466,
+	25102, 24730, 24351, 23965, 23571, 23170, 22763, 22348, 21926, 21498,
+	21063, 20622, 20174, 19720, 19261, 18795, 18324, 17847, 17364, 16877,
+	16384, 15886, 15384, 14876, 14365, 13848, 13328, 12803, 12275, 11743,
+	11207, 10668, 10126, 9580, 9032, 8481, 7927, 7371, 6813, 6252,
+	5690, 5126, 4560, 3993, 3425, 2856, 2286, 1715, 1144, 572,
+	0
+};
+
+/* atan(2^-i) in 1e-4 deg */
+static const int32_t cordic_atan[CORDIC_ITER] = {
+	450000, 265651, 140362, 71250, 35763, 17899, 8952, 4476,
+	2238, 1119, 560, 280, 140, 70, 35, 17
+};
+
+static int64_t div_round(int64_t num, int64_t den){
+	return (num >= 0) ? ((num + den / 2) / den) : ((num - den / 2) / den);
+}
+
+static int32_t clamp_mm(int64_t v){
+	if (v > GEO_DELTA_MAX_MM) return GEO_DELTA_MAX_MM;
+	if (v < -GEO_DELTA_MAX_MM) return -GEO_DELTA_MAX_MM;
+	return (int32_t)v;
+}
+
+int32_t geo_cos_q15(int32_t lat_e7){
+	uint32_t a = (lat_e7 < 0) ? (uint32_t)(-(int64_t)lat_e7) : (uint32_t)lat_e7;
+	uint32_t deg = a / E7_PER_DEG;
+	if (deg >= 90){
+		return 0;
+	}
+	int32_t c0 = cos_q15_tab[deg];
+	int32_t c1 = cos_q15_tab[deg + 1];
+	return c0 + (int32_t)(((int64_t)(c1 - c0) * (a % E7_PER_DEG)) / E7_PER_DEG);
+}
+
+/* cos of 0..180 deg given in 0.01 deg, folded onto the 0..90 table */
+static int32_t cos_cdeg(uint32_t cdeg){
+	if (cdeg <= 9000){
+		return geo_cos_q15((int32_t)(cdeg * 100000UL));
+	}
+	return -geo_cos_q15((int32_t)((18000 - cdeg) * 100000UL));
+}
+
+void geo_sin_cos_q15(uint16_t heading_cdeg, int32_t *sin_q15, int32_t *cos_q15){
+	uint32_t h = heading_cdeg % 36000U;
+	uint32_t c = (h <= 18000) ? h : (36000 - h);	// COS IS EVEN
+	uint32_t s = (h <= 27000) ? ((h >= 9000) ? (h - 9000) : (9000 - h)) : (45000 - h); // SIN(h) = COS(h - 90)
+	*cos_q15 = cos_cdeg(c);
+	*sin_q15 = cos_cdeg(s);
+}
+
+void geo_delta_mm(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7, int32_t *north_mm, int32_t *east_mm){
+	int64_t dlat = (int64_t)lat2_e7 - lat1_e7;
+	int64_t dlon = (int64_t)lon2_e7 - lon1_e7;
+	if (dlon > E7_180) dlon -= 2 * E7_180; // SHORT WAY ACROSS THE ANTIMERIDIAN
+	if (dlon < -E7_180) dlon += 2 * E7_180;
+
+	int32_t cos_mid = geo_cos_q15((int32_t)(((int64_t)lat1_e7 + lat2_e7) / 2));
+	*north_mm = clamp_mm(div_round(dlat * GEO_MM_PER_E7_NUM, GEO_MM_PER_E7_DEN));
+	*east_mm = clamp_mm(div_round(dlon * GEO_MM_PER_E7_NUM * cos_mid, (int64_t)GEO_MM_PER_E7_DEN << 15));
+}
+
+static uint32_t isqrt64(uint64_t v){
+	uint64_t root = 0;
+	uint64_t bit = 1ULL << 62;
+	while (bit > v){
+		bit >>= 2;
+	}
+	while (bit != 0){
+		if (v >= root + bit){
+			v -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)root;
+}
+
+uint32_t geo_distance_mm(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7){
+	int32_t n, e;
+	geo_delta_mm(lat1_e7, lon1_e7, lat2_e7, lon2_e7, &n, &e);
+	return isqrt64((uint64_t)((int64_t)n * n) + (uint64_t)((int64_t)e * e));
+}
+
+/* CORDIC vectoring: rotate (north, east) onto the north axis, summing the rotations */
+uint16_t geo_heading_cdeg(int32_t north_mm, int32_t east_mm){
+	int32_t x = north_mm;
+	int32_t y = east_mm;
+	int32_t z = 0;	// 1e-4 DEG
+
+	if ((x == 0) && (y == 0)){
+		return 0;
+	}
+	if (x < 0){
+		x = -x; // INPUTS ARE CLAMPED TO 2^30, NEGATION CANNOT OVERFLOW
+		y = -y;
+		z = 1800000;
+	}
+	/* Headroom for the 1.647 CORDIC gain, and enough bits for small vectors */
+	while ((x < (1L << 27)) && (y < (1L << 27)) && (y > -(1L << 27))){
+		x *= 2;
+		y *= 2;
+	}
+	while ((x >= (1L << 29)) || (y >= (1L << 29)) || (y <= -(1L << 29))){
+		x >>= 1;
+		y >>= 1;
+	}
+
+	for (int i = 0; i < CORDIC_ITER; i++){
+		int32_t xs = x >> i;
+		int32_t ys = y >> i;
+		if (y > 0){
+			x += ys;
+			y -= xs;
+			z += cordic_atan[i];
+		}
+		else{
+			x -= ys;
+			y += xs;
+			z -= cordic_atan[i];
+		}
+	}
+
+	int32_t cdeg = (int32_t)div_round(z, 100);
+	while (cdeg < 0) cdeg += 36000;
+	while (cdeg >= 36000) cdeg -= 36000;
+	return (uint16_t)cdeg;
+}
+
+uint16_t geo_bearing_cdeg(int32_t lat1_e7, int32_t lon1_e7, int32_t lat2_e7, int32_t lon2_e7){
+	int32_t n, e;
+	geo_delta_mm(lat1_e7, lon1_e7, lat2_e7, lon2_e7, &n, &e);
+	return geo_heading_cdeg(n, e);
+}
+
+void geo_offset(int32_t *lat_e7, int32_t *lon_e7, int32_t north_mm, int32_t east_mm){
+	int32_t cos_lat = geo_cos_q15(*lat_e7);
+	int64_t lat = *lat_e7 + div_round((int64_t)north_mm * GEO_MM_PER_E7_DEN, GEO_MM_PER_E7_NUM);
+	if (cos_lat > 0){
+		int64_t lon = *lon_e7 + div_round((int64_t)east_mm * GEO_MM_PER_E7_DEN * 32768, (int64_t)GEO_MM_PER_E7_NUM * cos_lat);
+		if (lon > E7_180) lon -= 2 * E7_180;
+		if (lon < -E7_180) lon += 2 * E7_180;
+		*lon_e7 = (int32_t)lon;
+	}
+	if (lat > 90 * E7_PER_DEG) lat = 90 * E7_PER_DEG;
+	if (lat < -90 * E7_PER_DEG) lat = -90 * E7_PER_DEG;
+	*lat_e7 = (int32_t)lat;
+}
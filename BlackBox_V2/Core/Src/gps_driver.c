@@ -6,27 +6,402 @@
  */
 #include "gps_driver.h"
 #include "main.h"
+#include "usart.h"
+#include "timebase.h"
 #include <stdbool.h>
+#include <string.h>
 
+#define GPS_BURSTS    8									// POWER OF TWO
 
-typedef struct {
-	bool locked;
-	float latitude;
-	float longitude;
-	float speed;
-} gps_data_t;
+#define GPS_CFG_BOOT_MS    1000	// RECEIVER STARTUP BEFORE THE FIRST COMMAND
+#define GPS_CFG_SETTLE_MS  100	// CFG-PRT SHIFTED OUT AND THE RECEIVER ON ITS NEW BAUD
+#define GPS_CFG_ACK_MS     300
+#define GPS_CFG_RETRIES    3
 
 gps_data_t gps;
+gps_stats_t gps_stats;
+gps_fix_t gps_fix;
+gps_mode_t gps_mode = GPS_MODE_NMEA;
+gps_time_t gps_time;
+
+static nmea_parser_t gps_nmea;
+static ubx_parser_t gps_ubx;
+static volatile uint32_t gps_byte_us;	// 8N1 CHARACTER TIME AT THE CURRENT BAUD
+
+/*
+ * UART4 fills gps_rx_buffer forever in circular DMA. The RX event callback
+ * (half, full, IDLE) only publishes how far DMA has written as a free-running
+ * byte count; the main loop frames sentences straight out of the buffer.
+ */
+static uint8_t gps_rx_buffer[GPS_RX_BUFFER_SIZE];
+static volatile uint32_t gps_rx_total = 0;	// BYTES WRITTEN BY DMA SINCE START
+static volatile uint16_t gps_rx_pos = 0;	// DMA WRITE INDEX AT THE LAST EVENT
+
+/* The receiver emits each epoch as one burst; its first byte is the best time reference */
+typedef struct {
+	uint32_t end_total;
+	uint32_t start_ts;
+} gps_burst_t;
+
+static gps_burst_t gps_bursts[GPS_BURSTS];
+static volatile uint32_t gps_burst_head = 0;
+static uint32_t gps_burst_start_total = 0;
+
+/* Main loop framing state */
+static uint32_t gps_read_total = 0;
+static uint32_t gps_sentence_start = 0;
+static bool gps_in_sentence = false;
+static uint32_t gps_burst_tail = 0;
+
+static void gps_rx_start(void){
+	gps_rx_pos = 0;
+	if (HAL_UARTEx_ReceiveToIdle_DMA(&huart4, gps_rx_buffer, GPS_RX_BUFFER_SIZE) != HAL_OK){
+		gps_stats.uart_errors++;
+	}
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size){
+	if (huart->Instance != UART4){
+		return;
+	}
+	uint32_t now = timebase_now_us();
+	uint16_t pos = Size & (GPS_RX_BUFFER_SIZE - 1); // FULL-TRANSFER EVENT REPORTS SIZE, I.E. INDEX 0
+	uint32_t total = gps_rx_total + ((uint32_t)(pos - gps_rx_pos) & (GPS_RX_BUFFER_SIZE - 1));
+	gps_rx_pos = pos;
+	gps_rx_total = total;
+
+	if (HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE){
+		/* Line went idle one character after the last byte: back-date to the burst start */
+		uint32_t burst_bytes = total - gps_burst_start_total;
+		gps_burst_t *b = &gps_bursts[gps_burst_head & (GPS_BURSTS - 1)];
+		b->end_total = total;
+		b->start_ts = now - ((burst_bytes + 1) * gps_byte_us);
+		__DMB();
+		gps_burst_head++;
+		gps_burst_start_total = total;
+	}
+}
+
+/* Noise/framing/overrun aborts the circular transfer in HAL; restart it, the gap is counted */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	if (huart->Instance != UART4){
+		return;
+	}
+	gps_stats.uart_errors++;
+	gps_rx_start();
+}
+
+/* Timestamp of the burst that holds the byte at absolute offset end */
+static uint32_t gps_burst_time(uint32_t end){
+	while (gps_burst_tail != gps_burst_head){
+		const gps_burst_t *b = &gps_bursts[gps_burst_tail & (GPS_BURSTS - 1)];
+		if ((int32_t)(b->end_total - end) >= 0){
+			return b->start_ts;
+		}
+		gps_burst_tail++;
+	}
+	return timebase_now_us(); // BURST STILL ARRIVING
+}
+
+static void gps_publish(uint32_t timestamp){
+	gps.locked = gps_fix.rmc_valid || (gps_fix.quality > 0);
+	gps.fix_type = gps_fix.fix_type;
+	gps.sats = gps_fix.sats;
+	gps.lat_e7 = gps_fix.lat_e7;
+	gps.lon_e7 = gps_fix.lon_e7;
+	gps.alt_mm = gps_fix.alt_mm;
+	gps.speed_mmps = gps_fix.speed_mmps;
+	gps.course_cdeg = gps_fix.course_cdeg;
+	gps.timestamp = timestamp;
+	gps.seq++;
+}
+
+static void gps_publish_time(uint32_t timestamp){
+	gps_time.utc_ms = gps_fix.time_ms;
+	gps_time.date = gps_fix.date;
+	gps_time.timestamp = timestamp;
+	gps_time.seq++;
+}
+
+static void gps_handle_sentence(const gps_sentence_t *sentence){
+	gps_stats.sentences++;
+	uint8_t done = nmea_feed_span(&gps_nmea, sentence->p[0], sentence->len[0], &gps_fix);
+	done |= nmea_feed_span(&gps_nmea, sentence->p[1], sentence->len[1], &gps_fix);
+
+	if (done & (NMEA_RMC | NMEA_GGA)){
+		gps_publish(sentence->timestamp);
+	}
+	if ((done & NMEA_RMC) && gps_fix.rmc_valid && (gps_fix.date != 0)){
+		gps_publish_time(sentence->timestamp); // RMC TIME IS ONLY TRUSTED WITH A FIX
+	}
+}
+
+/* Hand the sentence [start, end) to the parser as spans into the DMA buffer */
+static void gps_emit(uint32_t start, uint32_t end){
+	if ((gps_rx_total - start) > GPS_RX_BUFFER_SIZE){
+		gps_stats.overruns++; // DMA ALREADY REUSED THE FIRST BYTES
+		return;
+	}
+	gps_sentence_t sentence;
+	uint32_t offset = start & (GPS_RX_BUFFER_SIZE - 1);
+	uint32_t len = end - start;
+	uint32_t first = GPS_RX_BUFFER_SIZE - offset;
+	if (first > len){
+		first = len;
+	}
+	sentence.p[0] = &gps_rx_buffer[offset];
+	sentence.len[0] = (uint16_t)first;
+	sentence.p[1] = gps_rx_buffer;
+	sentence.len[1] = (uint16_t)(len - first);
+	sentence.timestamp = gps_burst_time(end - 1);
+	gps_handle_sentence(&sentence);
+}
+
+/*
+ * UBX configuration, driven from GPS_Driver_Update without blocking:
+ * CFG-PRT at 9600 moves the receiver to GPS_UBX_BAUD with UBX-only output
+ * (its ACK races the baud switch, so it is not waited for), then every
+ * following command must be ACK'd at the new baud. The first of those is
+ * the link check; anything missing restores NMEA at GPS_BAUD on both ends.
+ */
+typedef enum {
+	GPS_CFG_BOOT,
+	GPS_CFG_SETTLE,
+	GPS_CFG_SEND,
+	GPS_CFG_WAIT_ACK,
+	GPS_CFG_FALLBACK,
+	GPS_CFG_FALLBACK_SETTLE,
+	GPS_CFG_DONE
+} gps_cfg_phase_t;
+
+typedef enum {
+	GPS_ACK_NONE,
+	GPS_ACK_ACK,
+	GPS_ACK_NAK
+} gps_ack_t;
+
+typedef struct {
+	uint8_t cls;
+	uint8_t id;
+	const uint8_t *payload;
+	uint8_t len;
+	bool optional;	// NAK OR SILENCE IS NOT A FAILURE
+} gps_cfg_step_t;
+
+#define U16_LE(v) (uint8_t)((v) & 0xFF), (uint8_t)(((v) >> 8) & 0xFF)
+#define U32_LE(v) U16_LE((v) & 0xFFFF), U16_LE(((v) >> 16) & 0xFFFF)
+
+/* CFG-PRT, port 1 (UART1 on the module): 8N1, UBX+NMEA accepted, one protocol out */
+static const uint8_t cfg_prt_ubx[20] = {
+	0x01, 0x00, U16_LE(0), U32_LE(0x000008D0UL), U32_LE(GPS_UBX_BAUD),
+	U16_LE(0x0003), U16_LE(0x0001), U16_LE(0), U16_LE(0)
+};
+static const uint8_t cfg_prt_nmea[20] = {
+	0x01, 0x00, U16_LE(0), U32_LE(0x000008D0UL), U32_LE(GPS_BAUD),
+	U16_LE(0x0003), U16_LE(0x0002), U16_LE(0), U16_LE(0)
+};
+
+/* CFG-RATE: measurement period, one solution per measurement, aligned to GPS time */
+static const uint8_t cfg_rate[6] = { U16_LE(GPS_UBX_RATE_MS), U16_LE(1), U16_LE(1) };
+
+/* CFG-MSG: class, id, one message per solution */
+static const uint8_t cfg_msg_posllh[3] = { UBX_CLASS_NAV, UBX_NAV_POSLLH, 1 };
+static const uint8_t cfg_msg_sol[3] = { UBX_CLASS_NAV, UBX_NAV_SOL, 1 };
+static const uint8_t cfg_msg_velned[3] = { UBX_CLASS_NAV, UBX_NAV_VELNED, 1 };
+static const uint8_t cfg_msg_timeutc[3] = { UBX_CLASS_NAV, UBX_NAV_TIMEUTC, 1 };
+static const uint8_t cfg_msg_pvt[3] = { UBX_CLASS_NAV, UBX_NAV_PVT, 1 };
+
+static const gps_cfg_step_t gps_cfg_steps[] = {
+	{ UBX_CLASS_CFG, UBX_CFG_RATE, cfg_rate, sizeof(cfg_rate), false },
+	{ UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg_posllh, sizeof(cfg_msg_posllh), false },
+	{ UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg_sol, sizeof(cfg_msg_sol), false },
+	{ UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg_velned, sizeof(cfg_msg_velned), false },
+	{ UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg_timeutc, sizeof(cfg_msg_timeutc), true },
+	{ UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg_pvt, sizeof(cfg_msg_pvt), true }, // M8+ ONLY
+};
+#define GPS_CFG_STEPS (sizeof(gps_cfg_steps) / sizeof(gps_cfg_steps[0]))
+
+static uint8_t gps_tx_buffer[UBX_FRAME_OVERHEAD + 20];
+static gps_cfg_phase_t gps_cfg_phase = GPS_CFG_DONE;
+static uint32_t gps_cfg_tick = 0;
+static uint8_t gps_cfg_index = 0;
+static uint8_t gps_cfg_tries = 0;
+static gps_ack_t gps_cfg_ack = GPS_ACK_NONE;
+
+/*
+ * Retune UART4 in place so the circular RX DMA and its byte count run on.
+ * A write landing mid-character garbles at most that byte; both parsers
+ * resynchronise on their checksums.
+ */
+static void gps_set_baud(uint32_t baud){
+	huart4.Init.BaudRate = baud;
+	huart4.Instance->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), baud);
+	gps_byte_us = (10UL * 1000000UL) / baud;
+}
+
+static void gps_send(uint8_t cls, uint8_t id, const uint8_t *payload, uint8_t len){
+	uint16_t n = ubx_build(gps_tx_buffer, cls, id, payload, len);
+	if (HAL_UART_Transmit_IT(&huart4, gps_tx_buffer, n) != HAL_OK){
+		gps_stats.uart_errors++;
+	}
+}
+
+static void gps_config_run(void){
+	uint32_t now = HAL_GetTick();
+
+	if (huart4.gState != HAL_UART_STATE_READY){
+		return; // PREVIOUS COMMAND STILL SHIFTING OUT
+	}
+
+	switch (gps_cfg_phase){
+	case GPS_CFG_BOOT:
+		if ((now - gps_cfg_tick) >= GPS_CFG_BOOT_MS){
+			gps_send(UBX_CLASS_CFG, UBX_CFG_PRT, cfg_prt_ubx, sizeof(cfg_prt_ubx));
+			gps_cfg_tick = now;
+			gps_cfg_phase = GPS_CFG_SETTLE;
+		}
+		break;
+
+	case GPS_CFG_SETTLE:
+		if ((now - gps_cfg_tick) >= GPS_CFG_SETTLE_MS){
+			gps_set_baud(GPS_UBX_BAUD);
+			gps_cfg_index = 0;
+			gps_cfg_tries = 0;
+			gps_cfg_phase = GPS_CFG_SEND;
+		}
+		break;
+
+	case GPS_CFG_SEND: {
+		if (gps_cfg_index >= GPS_CFG_STEPS){
+			gps_mode = GPS_MODE_UBX;
+			gps_cfg_phase = GPS_CFG_DONE;
+			break;
+		}
+		const gps_cfg_step_t *step = &gps_cfg_steps[gps_cfg_index];
+		gps_cfg_ack = GPS_ACK_NONE;
+		gps_send(step->cls, step->id, step->payload, step->len);
+		gps_cfg_tick = now;
+		gps_cfg_phase = GPS_CFG_WAIT_ACK;
+		break;
+	}
+
+	case GPS_CFG_WAIT_ACK: {
+		const gps_cfg_step_t *step = &gps_cfg_steps[gps_cfg_index];
+		if (gps_cfg_ack == GPS_ACK_ACK){
+			gps_cfg_index++;
+			gps_cfg_tries = 0;
+			gps_cfg_phase = GPS_CFG_SEND;
+		}
+		else if ((gps_cfg_ack == GPS_ACK_NAK) || ((now - gps_cfg_tick) >= GPS_CFG_ACK_MS)){
+			if ((gps_cfg_ack == GPS_ACK_NONE) && (++gps_cfg_tries < GPS_CFG_RETRIES)){
+				gps_cfg_phase = GPS_CFG_SEND; // RESEND THE SAME STEP
+			}
+			else if (step->optional){
+				gps_cfg_index++;
+				gps_cfg_tries = 0;
+				gps_cfg_phase = GPS_CFG_SEND;
+			}
+			else{
+				gps_stats.cfg_failures++;
+				gps_cfg_phase = GPS_CFG_FALLBACK;
+			}
+		}
+		break;
+	}
+
+	case GPS_CFG_FALLBACK:
+		/* Harmless if the receiver never left 9600: it reads this as line noise */
+		gps_send(UBX_CLASS_CFG, UBX_CFG_PRT, cfg_prt_nmea, sizeof(cfg_prt_nmea));
+		gps_cfg_tick = now;
+		gps_cfg_phase = GPS_CFG_FALLBACK_SETTLE;
+		break;
+
+	case GPS_CFG_FALLBACK_SETTLE:
+		if ((now - gps_cfg_tick) >= GPS_CFG_SETTLE_MS){
+			gps_set_baud(GPS_BAUD);
+			nmea_init(&gps_nmea);
+			gps_mode = GPS_MODE_NMEA;
+			gps_cfg_phase = GPS_CFG_DONE;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* A UBX message ending at absolute offset end passed its checksum */
+static void gps_handle_ubx(uint8_t done, uint32_t end){
+	if ((done & UBX_ACK) && (gps_cfg_phase == GPS_CFG_WAIT_ACK)){
+		const gps_cfg_step_t *step = &gps_cfg_steps[gps_cfg_index];
+		if ((gps_ubx.ack_cls == step->cls) && (gps_ubx.ack_id == step->id)){
+			gps_cfg_ack = gps_ubx.ack_ok ? GPS_ACK_ACK : GPS_ACK_NAK;
+		}
+	}
+	if (done & UBX_TIME){
+		gps_publish_time(gps_burst_time(end - 1)); // validUTC ALREADY CHECKED BY THE PARSER
+	}
+	/* VELNED closes a NEO-6M epoch (PVT carries all of it); without a fix SOL is the last word */
+	if ((done & UBX_VEL) || ((done & UBX_STATUS) && !gps_fix.rmc_valid)){
+		gps_publish(gps_burst_time(end - 1));
+	}
+}
 
 void GPS_Driver_Init(void){
-	gps.locked = false;
-	gps.speed = 0.0;
-	gps.latitude = 0.0;
-	gps.longitude = 0.0;
+	memset(&gps, 0, sizeof(gps));
+	memset(&gps_time, 0, sizeof(gps_time));
+	nmea_init(&gps_nmea);
+	ubx_init(&gps_ubx);
+	gps_set_baud(GPS_BAUD);
+	gps_rx_start();
+#if GPS_UBX_ENABLE
+	gps_mode = GPS_MODE_CONFIG;
+	gps_cfg_phase = GPS_CFG_BOOT;
+	gps_cfg_tick = HAL_GetTick();
+#endif
 }
 
 void GPS_Driver_Update(void){
-	if (gps.locked){
+	uint32_t total = gps_rx_total;
+
+	if ((total - gps_read_total) > GPS_RX_BUFFER_SIZE){
+		gps_stats.overruns++;
+		gps_read_total = total - GPS_RX_BUFFER_SIZE;
+		gps_in_sentence = false;
+	}
+
+	while (gps_read_total != total){
+		uint8_t c = gps_rx_buffer[gps_read_total & (GPS_RX_BUFFER_SIZE - 1)];
+		gps_read_total++;
+		gps_stats.bytes++;
+
+		if (gps_mode != GPS_MODE_NMEA){
+			uint8_t done = ubx_feed(&gps_ubx, c, &gps_fix);
+			if (done){
+				gps_handle_ubx(done, gps_read_total);
+			}
+		}
+		if (gps_mode == GPS_MODE_UBX){
+			continue; // NMEA OUTPUT IS OFF, SKIP THE FRAMER
+		}
+
+		if (c == '$'){
+			gps_sentence_start = gps_read_total - 1;
+			gps_in_sentence = true;
+		}
+		else if (gps_in_sentence && (c == '\n')){
+			gps_in_sentence = false;
+			gps_emit(gps_sentence_start, gps_read_total);
+		}
+		else if (gps_in_sentence && ((gps_read_total - gps_sentence_start) > GPS_SENTENCE_MAX)){
+			gps_in_sentence = false;
+			gps_stats.oversize++;
+		}
+	}
 
+	gps_stats.ubx_frames = gps_ubx.frames;
+	gps_stats.ubx_errors = gps_ubx.errors;
+	if (gps_mode == GPS_MODE_CONFIG){
+		gps_config_run();
 	}
 }
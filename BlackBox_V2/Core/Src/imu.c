@@ -6,50 +6,314 @@
  */
 
 #include "imu.h"
+#include "imu_cal.h"
 #include "fault.h"
 #include "i2c.h"
 #include "iwdg.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include "main.h"
+#include "timebase.h"
+#include "prof.h"
 
 #define IMU_ADDR 0x68
 #define WAKE_REG 0x6B
 #define WRITE_ADDRESS (IMU_ADDR << 1)
 
+#define SMPLRT_DIV_REG  0x19
+#define CONFIG_REG      0x1A
+#define FIFO_EN_REG     0x23
+#define INT_PIN_CFG_REG 0x37
+#define INT_ENABLE_REG  0x38
+#define ACCEL_OUT_REG   59
+#define USER_CTRL_REG   0x6A
+#define FIFO_COUNT_REG  0x72
+#define FIFO_R_W_REG    0x74
+
+#define INT_RD_CLEAR    0x10	// ANY READ CLEARS INT_STATUS, PIN PULSES 50 US
+#define DATA_RDY_EN     0x01
+#define DLPF_188HZ      0x01	// ACCEL/GYRO 1 kHz INTERNAL RATE, WIDEST BAND THAT KEEPS IT
+#define DLPF_44HZ       0x03	// BELOW NYQUIST FOR 100 Hz DATA-READY MODE
+#define FIFO_EN_ALL     0xF8	// TEMP, XG, YG, ZG, ACCEL: SAME 14-BYTE ORDER AS REGISTERS 59..72
+#define USER_FIFO_EN    0x40
+#define USER_FIFO_RESET 0x04
+
+#define IMU_FRAME_BYTES     14
+#define IMU_FIFO_SIZE       1024
+#define IMU_FIFO_BATCH      10	// DATA-READY EDGES PER FIFO DRAIN (10 MS AT 1 kHz)
+#define IMU_FIFO_MAX_BURST  32	// FRAMES PER DMA READ, REMAINDER WAITS FOR THE NEXT DRAIN
+
+#define IMU_STALL_MS        25	// LONGEST BURST (448 BYTES) TAKES ~10 MS AT 400 kHz
+#define IMU_MAX_ERRORS      3	// CONSECUTIVE BUS ERRORS BEFORE imu_fault
+
+#define IMU_SAMPLE_PERIOD_US (1000000UL / IMU_SAMPLE_RATE_HZ)
+
+#if IMU_FIFO_MODE
+#define IMU_DLPF DLPF_188HZ
+#else
+#define IMU_DLPF DLPF_44HZ
+#endif
+
 imu_frame imu;
 imu_calibration imu_offset;
 uint8_t imu_who_am_i = 0;
+volatile uint32_t imu_dropped_count = 0;
+volatile uint32_t imu_missed_count = 0;
+volatile uint32_t imu_overflow_count = 0;
+
+/*
+ * Samples are produced by the I2C1 DMA complete callback and consumed by the
+ * main loop, same single-producer/single-consumer rules as can_ring_buffer.
+ */
+static imu_frame imu_rb[IMU_RB_CAPACITY];
+static volatile uint32_t imu_rb_head = 0;
+static volatile uint32_t imu_rb_tail = 0;
+
+typedef enum {
+	IMU_XFER_IDLE,
+	IMU_XFER_SAMPLE,	// 14-BYTE REGISTER READ (DATA-READY MODE)
+	IMU_XFER_COUNT,		// FIFO_COUNT READ
+	IMU_XFER_FIFO,		// BURST OF FRAMES FROM FIFO_R_W
+	IMU_XFER_RESET		// USER_CTRL WRITE AFTER AN OVERFLOW
+} imu_xfer_t;
+
+#if IMU_FIFO_MODE
+static uint8_t imu_dma_buffer[IMU_FIFO_MAX_BURST * IMU_FRAME_BYTES];
+#else
+static uint8_t imu_dma_buffer[IMU_FRAME_BYTES];
+#endif
+static uint8_t imu_reset_value = USER_FIFO_EN | USER_FIFO_RESET;
+static volatile bool imu_running = false;
+static volatile imu_xfer_t imu_xfer = IMU_XFER_IDLE;
+static volatile uint32_t imu_xfer_start_tick = 0;
+static volatile uint32_t imu_drdy_ts = 0;		// LATEST DATA-READY EDGE
+static volatile uint32_t imu_pushed_ts = 0;		// NEWEST SAMPLE IN THE RING
+static volatile uint8_t imu_error_streak = 0;
+#if IMU_FIFO_MODE
+static volatile uint8_t imu_drdy_since_drain = 0;
+static volatile uint16_t imu_fifo_frames = 0;	// FRAMES IN THE FIFO WHEN IT WAS COUNTED
+static volatile uint16_t imu_burst_frames = 0;	// FRAMES IN THE READ IN FLIGHT
+static volatile uint32_t imu_batch_ts = 0;		// TIMESTAMP OF THE NEWEST COUNTED FRAME
+#endif
+
+/* Register and FIFO frames share the layout: accel xyz, temp, gyro xyz, big-endian */
+static void imu_decode(const uint8_t *buffer, imu_frame *out){
+	out->accel_x = (int16_t)((buffer[0] << 8) | buffer[1]);
+	out->accel_y = (int16_t)((buffer[2] << 8) | buffer[3]);
+	out->accel_z = (int16_t)((buffer[4] << 8) | buffer[5]);
+	out->temp    = (int16_t)((buffer[6] << 8) | buffer[7]);
+	out->gyro_x  = (int16_t)((buffer[8] << 8) | buffer[9]);
+	out->gyro_y  = (int16_t)((buffer[10] << 8) | buffer[11]);
+	out->gyro_z  = (int16_t)((buffer[12] << 8) | buffer[13]);
+}
+
+/* Blocking read for init/calibration only, before the data-ready interrupt is enabled */
+static bool imu_read_blocking(imu_frame *out){
+	uint8_t buffer[IMU_FRAME_BYTES];
+	HAL_StatusTypeDef accel_status = HAL_I2C_Mem_Read(&hi2c1, WRITE_ADDRESS, ACCEL_OUT_REG, I2C_MEMADD_SIZE_8BIT, buffer, IMU_FRAME_BYTES, 100);
+	if (accel_status != HAL_OK){
+		return false;
+	}
+	imu_decode(buffer, out);
+	out->timestamp = timebase_now_us();
+	return true;
+}
+
+static bool imu_write_reg(uint8_t reg, uint8_t value){
+	return HAL_I2C_Mem_Write(&hi2c1, WRITE_ADDRESS, reg, I2C_MEMADD_SIZE_8BIT, &value, 1, 100) == HAL_OK;
+}
+
+static void imu_push(const uint8_t *raw, uint32_t ts){
+	if ((imu_rb_head - imu_rb_tail) >= IMU_RB_CAPACITY){
+		imu_dropped_count++;
+		return;
+	}
+	imu_frame *slot = &imu_rb[imu_rb_head & (IMU_RB_CAPACITY - 1)];
+	imu_decode(raw, slot);
+	slot->accel_x -= imu_offset.offset_x;
+	slot->accel_y -= imu_offset.offset_y;
+	slot->accel_z -= imu_offset.offset_z;
+	slot->gyro_x -= imu_offset.offset_gx;
+	slot->gyro_y -= imu_offset.offset_gy;
+	slot->gyro_z -= imu_offset.offset_gz;
+	slot->timestamp = ts;
+	__DMB(); // SLOT CONTENTS VISIBLE BEFORE THE NEW HEAD
+	imu_rb_head++;
+	imu_pushed_ts = ts;
+}
+
+static void imu_xfer_begin(imu_xfer_t xfer, HAL_StatusTypeDef status){
+	if (status == HAL_OK){
+		imu_xfer = xfer;
+		imu_xfer_start_tick = HAL_GetTick();
+	}
+	else{
+		imu_xfer = IMU_XFER_IDLE;
+		imu_missed_count++;
+	}
+}
+
+/* MPU_EXTI0 rising edge: a new sample is latched in the registers and the FIFO */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
+	if (GPIO_Pin != MPU_EXTI0_Pin || !imu_running){
+		return;
+	}
+	imu_drdy_ts = timebase_now_us(); // STAMP AT DATA READY, NOT AT DMA COMPLETE
+#if IMU_FIFO_MODE
+	if (++imu_drdy_since_drain < IMU_FIFO_BATCH){
+		return;
+	}
+	if (imu_xfer != IMU_XFER_IDLE){
+		return; // PREVIOUS DRAIN STILL RUNNING, FRAMES WAIT IN THE FIFO
+	}
+	imu_drdy_since_drain = 0;
+	imu_xfer_begin(IMU_XFER_COUNT, HAL_I2C_Mem_Read_DMA(&hi2c1, WRITE_ADDRESS, FIFO_COUNT_REG, I2C_MEMADD_SIZE_8BIT, imu_dma_buffer, 2));
+#else
+	if (imu_xfer != IMU_XFER_IDLE){
+		imu_missed_count++;
+		return;
+	}
+	imu_xfer_begin(IMU_XFER_SAMPLE, HAL_I2C_Mem_Read_DMA(&hi2c1, WRITE_ADDRESS, ACCEL_OUT_REG, I2C_MEMADD_SIZE_8BIT, imu_dma_buffer, IMU_FRAME_BYTES));
+#endif
+}
+
+#if IMU_FIFO_MODE
+/* FIFO_COUNT arrived: overflow or a partial frame means the stream lost alignment */
+static void imu_fifo_counted(void){
+	uint16_t count = (uint16_t)((imu_dma_buffer[0] << 8) | imu_dma_buffer[1]);
+	if ((count > (IMU_FIFO_SIZE - IMU_FRAME_BYTES)) || ((count % IMU_FRAME_BYTES) != 0)){
+		imu_overflow_count++;
+		imu_xfer_begin(IMU_XFER_RESET, HAL_I2C_Mem_Write_IT(&hi2c1, WRITE_ADDRESS, USER_CTRL_REG, I2C_MEMADD_SIZE_8BIT, &imu_reset_value, 1));
+		return;
+	}
+	imu_fifo_frames = count / IMU_FRAME_BYTES;
+	if (imu_fifo_frames == 0){
+		imu_xfer = IMU_XFER_IDLE;
+		return;
+	}
+	/* Newest counted frame belongs to the latest edge (+-1 sample if one lands mid-count) */
+	imu_batch_ts = imu_drdy_ts;
+	imu_burst_frames = (imu_fifo_frames > IMU_FIFO_MAX_BURST) ? IMU_FIFO_MAX_BURST : imu_fifo_frames;
+	imu_xfer_begin(IMU_XFER_FIFO, HAL_I2C_Mem_Read_DMA(&hi2c1, WRITE_ADDRESS, FIFO_R_W_REG, I2C_MEMADD_SIZE_8BIT, imu_dma_buffer, imu_burst_frames * IMU_FRAME_BYTES));
+}
+
+/* Frames come out oldest first; back-date each from the newest counted one */
+static void imu_fifo_burst_done(void){
+	for (uint16_t i = 0; i < imu_burst_frames; i++){
+		uint32_t age = (uint32_t)(imu_fifo_frames - 1 - i) * IMU_SAMPLE_PERIOD_US;
+		imu_push(&imu_dma_buffer[i * IMU_FRAME_BYTES], imu_batch_ts - age);
+	}
+	imu_xfer = IMU_XFER_IDLE;
+}
+#endif
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c){
+	if (hi2c->Instance != I2C1){
+		return;
+	}
+	imu_error_streak = 0;
+	switch (imu_xfer){
+#if IMU_FIFO_MODE
+	case IMU_XFER_COUNT:
+		imu_fifo_counted();
+		break;
+	case IMU_XFER_FIFO:
+		imu_fifo_burst_done();
+		break;
+#endif
+	case IMU_XFER_SAMPLE:
+		imu_push(imu_dma_buffer, imu_drdy_ts);
+		imu_xfer = IMU_XFER_IDLE;
+		break;
+	default:
+		imu_xfer = IMU_XFER_IDLE;
+		break;
+	}
+}
+
+/* FIFO reset written: samples restart from an empty, frame-aligned FIFO */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c){
+	if (hi2c->Instance != I2C1){
+		return;
+	}
+	imu_xfer = IMU_XFER_IDLE;
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c){
+	if (hi2c->Instance != I2C1){
+		return;
+	}
+	imu_xfer = IMU_XFER_IDLE;
+	if (++imu_error_streak >= IMU_MAX_ERRORS){
+		imu_running = false;
+		fault_flags.imu_fault = true;
+	}
+}
+
+const imu_frame *imu_ring_peek(void){
+	if (imu_rb_head == imu_rb_tail){
+		return NULL;
+	}
+	__DMB(); // READ head BEFORE THE SLOT
+	return &imu_rb[imu_rb_tail & (IMU_RB_CAPACITY - 1)];
+}
+
+void imu_ring_release(void){
+	__DMB(); // FINISH READING THE SLOT BEFORE HANDING IT BACK
+	imu_rb_tail++;
+}
+
+bool imu_ring_pop(imu_frame *out){
+	const imu_frame *slot = imu_ring_peek();
+	if (slot == NULL){
+		return false;
+	}
+	*out = *slot;
+	imu_ring_release();
+	return true;
+}
+
+bool imu_streaming(void){
+	return imu_running;
+}
+
+uint32_t imu_horizon(void){
+	return imu_pushed_ts;
+}
 
 void imu_read(void){
-	if (!fault_flags.imu_fault && !fault_flags.imu_handshake_fault ){
-		uint8_t buffer[6];
-		HAL_StatusTypeDef accel_status =  HAL_I2C_Mem_Read(&hi2c1, WRITE_ADDRESS, 59, I2C_MEMADD_SIZE_8BIT, buffer, 6, 100);
-		if (accel_status != HAL_OK){
-			fault_flags.imu_fault = true;
-			return;
-		}
-		imu.accel_x = (int16_t)((buffer[0] << 8) | buffer[1]);
-		imu.accel_y = (int16_t)((buffer[2] << 8) | buffer[3]);
-		imu.accel_z = (int16_t)((buffer[4] << 8) | buffer[5]);
-		imu.accel_x -= imu_offset.offset_x;
-		imu.accel_y -= imu_offset.offset_y;
-		imu.accel_z -= imu_offset.offset_z;
-		imu.timestamp = HAL_GetTick();
+	PROF_START(IMU_READ);
+	if (imu_running && (imu_xfer != IMU_XFER_IDLE) && ((HAL_GetTick() - imu_xfer_start_tick) >= IMU_STALL_MS)){
+		imu_running = false; // BUS HUNG MID-TRANSFER
+		fault_flags.imu_fault = true;
+	}
+	while (imu_ring_pop(&imu)){
+		imu_cal_observe(&imu); // KEEP THE NEWEST SAMPLE
 	}
+	PROF_STOP(IMU_READ);
 }
 
 void imu_calibrate(void){ // ZERO CALIBRATION UPON START
 	int32_t sum_x = 0;
 	int32_t sum_y = 0;
 	int32_t sum_z = 0;
+	int32_t sum_gx = 0;
+	int32_t sum_gy = 0;
+	int32_t sum_gz = 0;
 	if ((fault_flags.imu_fault == false) && (fault_flags.imu_handshake_fault == 0)){
 
 		for (int i = 0; i < 50; i++){
-			imu_read();
-			sum_x += imu.accel_x;
-			sum_y += imu.accel_y;
-			sum_z += imu.accel_z;
+			imu_frame sample;
+			if (!imu_read_blocking(&sample)){
+				fault_flags.imu_fault = true;
+				return;
+			}
+			sum_x += sample.accel_x;
+			sum_y += sample.accel_y;
+			sum_z += sample.accel_z;
+			sum_gx += sample.gyro_x;
+			sum_gy += sample.gyro_y;
+			sum_gz += sample.gyro_z;
 			HAL_IWDG_Refresh(&hiwdg);
 			HAL_Delay(20);
 		}
@@ -57,9 +321,39 @@ void imu_calibrate(void){ // ZERO CALIBRATION UPON START
 		imu_offset.offset_x = (int16_t)(sum_x / 50);
 		imu_offset.offset_y = (int16_t)(sum_y / 50);
 		imu_offset.offset_z = (int16_t)(sum_z / 50);
+		imu_offset.offset_gx = (int16_t)(sum_gx / 50);
+		imu_offset.offset_gy = (int16_t)(sum_gy / 50);
+		imu_offset.offset_gz = (int16_t)(sum_gz / 50);
 	}
 }
 
+/* Data ready on MPU_EXTI0 (PB0) paces the DMA reads from here on */
+static void imu_start(void){
+	if (fault_flags.imu_fault || fault_flags.imu_handshake_fault){
+		return;
+	}
+#if IMU_FIFO_MODE
+	/* Empty, frame-aligned FIFO collecting accel + temp + gyro from the next sample on */
+	if (!imu_write_reg(FIFO_EN_REG, FIFO_EN_ALL) || !imu_write_reg(USER_CTRL_REG, USER_FIFO_RESET) ||
+	    !imu_write_reg(USER_CTRL_REG, USER_FIFO_EN)){
+		fault_flags.imu_fault = true;
+		return;
+	}
+	imu_drdy_since_drain = 0;
+#endif
+	if (!imu_write_reg(INT_PIN_CFG_REG, INT_RD_CLEAR) || !imu_write_reg(INT_ENABLE_REG, DATA_RDY_EN)){
+		fault_flags.imu_fault = true;
+		return;
+	}
+	imu_xfer = IMU_XFER_IDLE;
+	imu_rb_head = 0;
+	imu_rb_tail = 0;
+	imu_running = true;
+	__HAL_GPIO_EXTI_CLEAR_IT(MPU_EXTI0_Pin);
+	HAL_NVIC_SetPriority(EXTI0_IRQn, 2, 0); // SAME GROUP AS I2C1/DMA1 SO THEY NEVER PREEMPT EACH OTHER
+	HAL_NVIC_EnableIRQ(EXTI0_IRQn);
+}
+
 void imu_init(void){
 
 	uint8_t sleep_bit = 0x00;
@@ -75,5 +369,17 @@ void imu_init(void){
 	if (imu_who_am_i != 0x68){
 		fault_flags.imu_handshake_fault = true;
 	}
-	imu_calibrate();
+	if (!fault_flags.imu_fault){
+		if (!imu_write_reg(CONFIG_REG, IMU_DLPF) || !imu_write_reg(SMPLRT_DIV_REG, (1000 / IMU_SAMPLE_RATE_HZ) - 1)){
+			fault_flags.imu_fault = true;
+		}
+	}
+	/* Stored offsets skip the ~1 s stationary calibration; background refinement keeps them current */
+	if (!imu_cal_load(&imu_offset)){
+		imu_calibrate();
+		if (!fault_flags.imu_fault && !fault_flags.imu_handshake_fault){
+			imu_cal_save(&imu_offset);
+		}
+	}
+	imu_start();
 }
@@ -0,0 +1,137 @@
+/*
+ * imu_cal.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// PERSISTED IMU OFFSETS + BACKGROUND REFINEMENT WHILE THE CAR IS STOPPED
+
+#include "imu_cal.h"
+#include "can_decode.h"
+#include "rtc.h"
+#include <string.h>
+
+#define IMU_CAL_MAGIC     0x494D5531UL	// "IMU1", BUMP IF imu_calibration CHANGES
+#define IMU_CAL_REG_MAGIC RTC_BKP_DR1
+#define IMU_CAL_REG_DATA  RTC_BKP_DR2	// DR2..DR4: SIX PACKED INT16 OFFSETS
+#define IMU_CAL_REG_CHECK RTC_BKP_DR5
+#define IMU_CAL_WORDS     3
+#define IMU_CAL_AXES      6
+
+uint32_t imu_cal_updates = 0;
+
+/* Per-window accumulators: sum and sum of squares of the residual per axis */
+static int32_t cal_sum[IMU_CAL_AXES];
+static int64_t cal_sq[IMU_CAL_AXES];
+static uint32_t cal_count = 0;
+
+static void cal_pack(const imu_calibration *cal, uint32_t words[IMU_CAL_WORDS]){
+	words[0] = (uint16_t)cal->offset_x | ((uint32_t)(uint16_t)cal->offset_y << 16);
+	words[1] = (uint16_t)cal->offset_z | ((uint32_t)(uint16_t)cal->offset_gx << 16);
+	words[2] = (uint16_t)cal->offset_gy | ((uint32_t)(uint16_t)cal->offset_gz << 16);
+}
+
+/* FNV-1a over magic + data: a blank or half-written domain never passes */
+static uint32_t cal_check(const uint32_t words[IMU_CAL_WORDS]){
+	uint32_t h = 2166136261UL;
+	uint32_t all[IMU_CAL_WORDS + 1] = { IMU_CAL_MAGIC, words[0], words[1], words[2] };
+	const uint8_t *p = (const uint8_t *)all;
+	for (uint32_t i = 0; i < sizeof(all); i++){
+		h = (h ^ p[i]) * 16777619UL;
+	}
+	return h;
+}
+
+bool imu_cal_load(imu_calibration *cal){
+	uint32_t words[IMU_CAL_WORDS];
+	if (HAL_RTCEx_BKUPRead(&hrtc, IMU_CAL_REG_MAGIC) != IMU_CAL_MAGIC){
+		return false;
+	}
+	for (int i = 0; i < IMU_CAL_WORDS; i++){
+		words[i] = HAL_RTCEx_BKUPRead(&hrtc, IMU_CAL_REG_DATA + i);
+	}
+	if (HAL_RTCEx_BKUPRead(&hrtc, IMU_CAL_REG_CHECK) != cal_check(words)){
+		return false;
+	}
+	cal->offset_x = (int16_t)(words[0] & 0xFFFF);
+	cal->offset_y = (int16_t)(words[0] >> 16);
+	cal->offset_z = (int16_t)(words[1] & 0xFFFF);
+	cal->offset_gx = (int16_t)(words[1] >> 16);
+	cal->offset_gy = (int16_t)(words[2] & 0xFFFF);
+	cal->offset_gz = (int16_t)(words[2] >> 16);
+	return true;
+}
+
+/* Magic last: a reset mid-save leaves the old magic with a failing checksum */
+void imu_cal_save(const imu_calibration *cal){
+	uint32_t words[IMU_CAL_WORDS];
+	cal_pack(cal, words);
+	HAL_RTCEx_BKUPWrite(&hrtc, IMU_CAL_REG_MAGIC, 0);
+	for (int i = 0; i < IMU_CAL_WORDS; i++){
+		HAL_RTCEx_BKUPWrite(&hrtc, IMU_CAL_REG_DATA + i, words[i]);
+	}
+	HAL_RTCEx_BKUPWrite(&hrtc, IMU_CAL_REG_CHECK, cal_check(words));
+	HAL_RTCEx_BKUPWrite(&hrtc, IMU_CAL_REG_MAGIC, IMU_CAL_MAGIC);
+}
+
+static void cal_window_reset(void){
+	memset(cal_sum, 0, sizeof(cal_sum));
+	memset(cal_sq, 0, sizeof(cal_sq));
+	cal_count = 0;
+}
+
+static int16_t cal_step(int16_t offset, int32_t mean){
+	int32_t step = mean / (1 << IMU_CAL_EMA_SHIFT); // ROUNDS TOWARD ZERO, NO LIMIT CYCLE AROUND THE TRUE BIAS
+	int32_t next = offset + step;
+	if (next > INT16_MAX){
+		next = INT16_MAX;
+	}
+	else if (next < INT16_MIN){
+		next = INT16_MIN;
+	}
+	return (int16_t)next;
+}
+
+/*
+ * A window only counts if ENGINE_DATA reported zero speed for all of it and
+ * every axis stayed quiet; the mean residual of such a window is bias.
+ */
+void imu_cal_observe(const imu_frame *sample){
+	if (!vehicle_is_stationary()){
+		cal_window_reset();
+		return;
+	}
+
+	const int16_t axis[IMU_CAL_AXES] = {
+		sample->accel_x, sample->accel_y, sample->accel_z, sample->gyro_x, sample->gyro_y, sample->gyro_z
+	};
+	for (int i = 0; i < IMU_CAL_AXES; i++){
+		cal_sum[i] += axis[i];
+		cal_sq[i] += (int32_t)axis[i] * axis[i];
+	}
+	if (++cal_count < IMU_CAL_WINDOW_SAMPLES){
+		return;
+	}
+
+	int32_t mean[IMU_CAL_AXES];
+	for (int i = 0; i < IMU_CAL_AXES; i++){
+		mean[i] = cal_sum[i] / (int32_t)cal_count;
+		int64_t var = (cal_sq[i] / cal_count) - ((int64_t)mean[i] * mean[i]);
+		int64_t limit = (i < 3) ? IMU_CAL_ACCEL_VAR_MAX : IMU_CAL_GYRO_VAR_MAX;
+		if (var > limit){
+			cal_window_reset();
+			return;
+		}
+	}
+
+	imu_offset.offset_x = cal_step(imu_offset.offset_x, mean[0]);
+	imu_offset.offset_y = cal_step(imu_offset.offset_y, mean[1]);
+	imu_offset.offset_z = cal_step(imu_offset.offset_z, mean[2]);
+	imu_offset.offset_gx = cal_step(imu_offset.offset_gx, mean[3]);
+	imu_offset.offset_gy = cal_step(imu_offset.offset_gy, mean[4]);
+	imu_offset.offset_gz = cal_step(imu_offset.offset_gz, mean[5]);
+	imu_cal_save(&imu_offset);
+	imu_cal_updates++;
+	cal_window_reset();
+}
@@ -0,0 +1,114 @@
+/*
+ * imu_filter.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// Q15 ANTI-ALIAS FIR + DECIMATION BETWEEN THE IMU RING AND THE LOG
+
+#include "imu_filter.h"
+#include "imu_filter_taps.h"
+#include "main.h"
+#include <string.h>
+
+#define IMU_FILTER_CHANNELS 6	// ACCEL XYZ, GYRO XYZ; TEMP IS DECIMATED WITHOUT FILTERING
+
+/*
+ * Polyphase decimation: history is written at the sensor rate but the dot
+ * product only runs once per IMU_FILTER_DECIMATION inputs. Each channel's
+ * history is stored twice back to back so the newest IMU_FILTER_TAPS samples
+ * are always contiguous and can be fetched two at a time. imu_filter_coeffs
+ * (imu_filter_taps.h) is time-reversed: coeffs[0] meets the oldest sample.
+ */
+static int16_t imu_filter_hist[IMU_FILTER_CHANNELS][2 * IMU_FILTER_TAPS];
+static uint32_t imu_filter_pos = 0;		// NEXT WRITE INDEX, 0..TAPS-1
+static uint32_t imu_filter_phase = 0;
+
+/*
+ * Dual 16x16 multiply-accumulate. The C version is the host reference for
+ * __SMLAD, so builds without the DSP extension produce bit-identical output.
+ */
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define imu_filter_smlad(x, y, acc) ((int32_t)__SMLAD((x), (y), (uint32_t)(acc)))
+#else
+static inline int32_t imu_filter_smlad(uint32_t x, uint32_t y, int32_t acc){
+	int32_t lo = (int32_t)(int16_t)(x & 0xFFFF) * (int16_t)(y & 0xFFFF);
+	int32_t hi = (int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16);
+	return (int32_t)((uint32_t)acc + (uint32_t)lo + (uint32_t)hi);
+}
+#endif
+
+static inline uint32_t imu_filter_load_pair(const int16_t *p){
+	uint32_t v;
+	memcpy(&v, p, sizeof(v)); // UNALIGNED LDR IS FINE ON M4, NEVER LDRD/LDM
+	return v;
+}
+
+/*
+ * The taps are a const table designed offline (tools/gen_imu_taps.py), so the
+ * output does not depend on libm or the FPU rounding mode. The generator
+ * checks that full-scale input cannot overflow the 32-bit SMLAD accumulator.
+ */
+void imu_filter_init(void){
+	imu_filter_reset();
+}
+
+void imu_filter_reset(void){
+	memset(imu_filter_hist, 0, sizeof(imu_filter_hist));
+	imu_filter_pos = 0;
+	imu_filter_phase = 0;
+}
+
+#if IMU_FILTER_DECIMATION > 1
+static int16_t imu_filter_dot(const int16_t *window){
+	int32_t acc = 0;
+	for (int k = 0; k < IMU_FILTER_TAPS; k += 2){
+		acc = imu_filter_smlad(imu_filter_load_pair(&window[k]), imu_filter_load_pair(&imu_filter_coeffs[k]), acc);
+	}
+	acc = (acc + (1 << 14)) >> 15; // ROUND Q30 -> Q15
+	if (acc > INT16_MAX){
+		acc = INT16_MAX;
+	}
+	else if (acc < INT16_MIN){
+		acc = INT16_MIN;
+	}
+	return (int16_t)acc;
+}
+#endif
+
+bool imu_filter_push(const imu_frame *in, imu_frame *out){
+#if IMU_FILTER_DECIMATION <= 1
+	*out = *in;
+	return true;
+#else
+	const int16_t sample[IMU_FILTER_CHANNELS] = {
+		in->accel_x, in->accel_y, in->accel_z, in->gyro_x, in->gyro_y, in->gyro_z
+	};
+	for (int ch = 0; ch < IMU_FILTER_CHANNELS; ch++){
+		imu_filter_hist[ch][imu_filter_pos] = sample[ch];
+		imu_filter_hist[ch][imu_filter_pos + IMU_FILTER_TAPS] = sample[ch];
+	}
+	imu_filter_pos = (imu_filter_pos + 1) % IMU_FILTER_TAPS;
+
+	if (++imu_filter_phase < IMU_FILTER_DECIMATION){
+		return false;
+	}
+	imu_filter_phase = 0;
+
+	/* Oldest sample of the newest window sits at imu_filter_pos */
+	int16_t result[IMU_FILTER_CHANNELS];
+	for (int ch = 0; ch < IMU_FILTER_CHANNELS; ch++){
+		result[ch] = imu_filter_dot(&imu_filter_hist[ch][imu_filter_pos]);
+	}
+	out->accel_x = result[0];
+	out->accel_y = result[1];
+	out->accel_z = result[2];
+	out->gyro_x = result[3];
+	out->gyro_y = result[4];
+	out->gyro_z = result[5];
+	out->temp = in->temp;
+	out->timestamp = in->timestamp - IMU_FILTER_DELAY_US;
+	return true;
+#endif
+}
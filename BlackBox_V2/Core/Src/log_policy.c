@@ -0,0 +1,115 @@
+/*
+ * log_policy.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// PER-ID LOGGING POLICY: DECIMATE REPEATING BROADCASTS BEFORE THEY COST STAGE BYTES
+
+#include "log_policy.h"
+#include "timebase.h"
+#include <string.h>
+
+/* KEEP SORTED BY ID: looked up with a binary search on every drained frame */
+static const log_policy_entry_t log_policy_table[] = {
+	{ 0x123, LOG_POLICY_ON_CHANGE, 1000 },	// BENCH LOOPBACK TEST FRAME, CONSTANT PAYLOAD
+	{ 0x158, LOG_POLICY_EVERY,        0 },	// ENGINE_DATA: RPM + SPEED, FULL RATE FOR ANALYSIS
+};
+
+#define LOG_POLICY_TABLE_LEN (sizeof(log_policy_table) / sizeof(log_policy_table[0]))
+
+/* Last logged payload per table entry, same index as log_policy_table */
+typedef struct {
+	uint8_t data[8];
+	uint8_t dlc;
+	bool valid;
+	uint16_t skipped;		// SATURATES, FLUSHED AT LEAST EVERY LOG_POLICY_SUMMARY_MS
+	uint32_t last_ts;		// timebase_now_us() OF THE LAST LOGGED FRAME
+} log_policy_cache_t;
+
+static log_policy_cache_t log_policy_cache[LOG_POLICY_TABLE_LEN];
+
+static int log_policy_find(uint32_t id){
+	int lo = 0;
+	int hi = (int)LOG_POLICY_TABLE_LEN - 1;
+	while (lo <= hi){
+		int mid = (lo + hi) / 2;
+		if (log_policy_table[mid].id == id){
+			return mid;
+		}
+		if (log_policy_table[mid].id < id){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid - 1;
+		}
+	}
+	return -1;
+}
+
+void log_policy_reset(void){
+	memset(log_policy_cache, 0, sizeof(log_policy_cache));
+}
+
+static bool log_policy_period_elapsed(const log_policy_cache_t *c, const can_frame_t *frame, uint16_t period_ms){
+	return (frame->timestamp - c->last_ts) >= ((uint32_t)period_ms * (TIMEBASE_HZ / 1000U));
+}
+
+bool log_policy_admit(const can_frame_t *frame, uint16_t *skipped){
+	*skipped = 0;
+	int idx = log_policy_find(frame->id);
+	if (idx < 0){
+		return LOG_POLICY_DEFAULT_MODE != LOG_POLICY_DROP;
+	}
+
+	const log_policy_entry_t *p = &log_policy_table[idx];
+	log_policy_cache_t *c = &log_policy_cache[idx];
+	uint8_t dlc = (frame->dlc > 8) ? 8 : frame->dlc;
+	bool admit;
+
+	switch (p->mode){
+	case LOG_POLICY_ON_CHANGE:
+		admit = !c->valid || (c->dlc != dlc) || (memcmp(c->data, frame->data, dlc) != 0) ||
+		        ((p->period_ms != 0) && log_policy_period_elapsed(c, frame, p->period_ms));
+		break;
+	case LOG_POLICY_RATE_LIMIT:
+		admit = !c->valid || log_policy_period_elapsed(c, frame, p->period_ms);
+		break;
+	case LOG_POLICY_DROP:
+		admit = false;
+		break;
+	default:
+		admit = true;
+		break;
+	}
+
+	if (!admit){
+		if (c->skipped != 0xFFFF){
+			c->skipped++;
+		}
+		return false;
+	}
+
+	memcpy(c->data, frame->data, dlc);
+	c->dlc = dlc;
+	c->valid = true;
+	c->last_ts = frame->timestamp;
+	*skipped = c->skipped;
+	c->skipped = 0;
+	return true;
+}
+
+bool log_policy_next_skipped(uint32_t *cursor, uint16_t *id, uint16_t *skipped){
+	while (*cursor < LOG_POLICY_TABLE_LEN){
+		log_policy_cache_t *c = &log_policy_cache[*cursor];
+		(*cursor)++;
+		if (c->skipped != 0){
+			*id = log_policy_table[*cursor - 1].id;
+			*skipped = c->skipped;
+			c->skipped = 0;
+			return true;
+		}
+	}
+	return false;
+}
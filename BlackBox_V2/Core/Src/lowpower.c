@@ -0,0 +1,229 @@
+/*
+ * lowpower.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// STOP-MODE IDLE: CAN RX EDGE AND RTC WAKEUP, TIME CARRIED ACROSS THE SLEEP, WAKE LATENCY
+
+#include "lowpower.h"
+#include "main.h"
+#include "can.h"
+#include "i2c.h"
+#include "iwdg.h"
+#include "rtc.h"
+#include "usart.h"
+#include "fatfs.h"
+#include "can_handler.h"
+#include "clock_profile.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "trace.h"
+#include <stdio.h>
+
+#define LOWPOWER_CAN_EXTI     EXTI_IMR_MR8		// CAN1_RX ON PB8
+#define LOWPOWER_RTC_EXTI     EXTI_IMR_MR22		// RTC WAKEUP TIMER
+#define LOWPOWER_IMU_EXTI     EXTI_IMR_MR0		// MPU_EXTI0 DATA READY
+
+/* Wakeup timer on RTCCLK/16: 2 kHz at the nominal LSI, the same clock the IWDG counts */
+#define LOWPOWER_RTC_COUNT    ((LOWPOWER_RTC_WAKE_MS * (LSI_VALUE / 16U)) / 1000U - 1U)
+
+lowpower_stats_t lowpower_stats;
+
+static uint32_t lp_idle_since = 0;		// HAL_GetTick WHEN SYS_IDLE WAS ENTERED
+static uint32_t lp_awake_since = 0;		// HAL_GetTick AT THE LAST WAKE
+static bool lp_slept = false;			// SINCE SYS_IDLE WAS ENTERED
+static bool lp_first_pending = false;	// CAN WAKE, FIRST FRAME NOT SEEN YET
+static uint32_t lp_wake_ready_ts = 0;	// TIMEBASE WHEN bxCAN WAS BACK ON THE BUS
+static uint32_t lp_wake_us = 0;
+
+void lowpower_init(void){
+	/* PB8 stays in its CAN alternate function; EXTI taps the input path */
+	__HAL_RCC_SYSCFG_CLK_ENABLE();
+	MODIFY_REG(SYSCFG->EXTICR[2], SYSCFG_EXTICR3_EXTI8, SYSCFG_EXTICR3_EXTI8_PB);
+	CLEAR_BIT(EXTI->RTSR, LOWPOWER_CAN_EXTI);
+	SET_BIT(EXTI->FTSR, LOWPOWER_CAN_EXTI);	// SOF IS THE FIRST DOMINANT (LOW) BIT
+	CLEAR_BIT(EXTI->IMR, LOWPOWER_CAN_EXTI);	// ARMED ONLY WHILE IN STOP
+	EXTI->PR = LOWPOWER_CAN_EXTI;
+
+	HAL_NVIC_SetPriority(EXTI9_5_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+	HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+	lp_idle_since = HAL_GetTick();
+	lp_slept = false;
+}
+
+/* EXTI8: the CAN edge that woke us; one-shot until the next STOP */
+void lowpower_exti_isr(void){
+	CLEAR_BIT(EXTI->IMR, LOWPOWER_CAN_EXTI);
+	EXTI->PR = LOWPOWER_CAN_EXTI;
+}
+
+/* RTC calendar in sub-second ticks since midnight; reading SSR locks TR and DR until DR is read */
+static uint32_t lp_rtc_ticks(void){
+	uint32_t ssr = RTC->SSR;
+	uint32_t tr = RTC->TR;
+	(void)RTC->DR;
+	uint32_t hh = RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos));
+	uint32_t mm = RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos));
+	uint32_t ss = RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos));
+	uint32_t prediv_s = hrtc.Init.SynchPrediv;
+	return ((hh * 60U + mm) * 60U + ss) * (prediv_s + 1U) + (prediv_s - ssr);
+}
+
+/* Milliseconds between two lp_rtc_ticks readings at the nominal LSI; good to the LSI's few percent */
+static uint32_t lp_rtc_elapsed_ms(uint32_t before, uint32_t after){
+	uint32_t day = 86400U * (hrtc.Init.SynchPrediv + 1U);
+	uint32_t ticks = (after + day - before) % day;
+	return (uint32_t)(((uint64_t)ticks * (hrtc.Init.AsynchPrediv + 1U) * 1000U) / LSI_VALUE);
+}
+
+/* The shadow calendar is stale after STOP until RSF is set again */
+static void lp_rtc_sync(void){
+	__HAL_RTC_WRITEPROTECTION_DISABLE(&hrtc);
+	HAL_RTC_WaitForSynchro(&hrtc);
+	__HAL_RTC_WRITEPROTECTION_ENABLE(&hrtc);
+}
+
+/* Nothing may be mid-transfer when the clocks stop, and the rings must be empty for the first-frame probe */
+static bool lp_quiet(void){
+	return (hi2c1.State == HAL_I2C_STATE_READY) && trace_idle() && !SD_IO_Pending() &&
+	       (CANRingBuffer_Count(&can_rb) == 0) && (CANRingBuffer_Count(&can_rb_priority) == 0) &&
+	       !can_frame_received_flag;
+}
+
+static void lowpower_stop(void){
+	/* IMU data-ready off first, so no transfer can start behind the check */
+	CLEAR_BIT(EXTI->IMR, LOWPOWER_IMU_EXTI);
+	if (!lp_quiet()){
+		SET_BIT(EXTI->IMR, LOWPOWER_IMU_EXTI);
+		lowpower_stats.aborted++;
+		return;
+	}
+	if (lp_first_pending){
+		lp_first_pending = false; // THE LAST CAN WAKE NEVER PRODUCED A FRAME
+		lowpower_stats.no_frame++;
+	}
+	HAL_CAN_RequestSleep(&hcan1);
+	uint32_t start = HAL_GetTick();
+	while (!HAL_CAN_IsSleepActive(&hcan1)){
+		if ((HAL_GetTick() - start) >= LOWPOWER_CAN_SLEEP_MS){
+			HAL_CAN_WakeUp(&hcan1);
+			SET_BIT(EXTI->IMR, LOWPOWER_IMU_EXTI);
+			lowpower_stats.aborted++;
+			return;
+		}
+	}
+
+	EXTI->PR = LOWPOWER_CAN_EXTI;
+	SET_BIT(EXTI->IMR, LOWPOWER_CAN_EXTI);
+	HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, LOWPOWER_RTC_COUNT, RTC_WAKEUPCLOCK_RTCCLK_DIV16);
+	uint32_t rtc_before = lp_rtc_ticks();
+	HAL_IWDG_Refresh(&hiwdg);
+	lowpower_stats.stops++;
+
+	/* Masked: WFI still wakes on the pending line, and the clocks are back before any handler runs */
+	__disable_irq();
+	HAL_SuspendTick();
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+	uint32_t wake_cycles = DWT->CYCCNT;
+	uint32_t pending = EXTI->PR;
+	HAL_ResumeTick();
+	uint32_t hsi_us = clock_profile_resume(wake_cycles);
+	uint32_t pll_cycles = DWT->CYCCNT;
+	__enable_irq();
+
+	HAL_CAN_WakeUp(&hcan1); // RETURNS ONCE 11 RECESSIVE BITS HAVE RESYNCED IT TO THE BUS
+	uint32_t ready_ts = timebase_now_us();
+	lp_wake_us = hsi_us + scheduler_cycles_to_us(DWT->CYCCNT - pll_cycles);
+	CLEAR_BIT(EXTI->IMR, LOWPOWER_CAN_EXTI);
+	SET_BIT(EXTI->IMR, LOWPOWER_IMU_EXTI);
+	HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+	HAL_IWDG_Refresh(&hiwdg);
+
+	/* TIM2 and SysTick stood still: carry both forward by the RTC's count of the sleep */
+	lp_rtc_sync();
+	uint32_t slept_ms = lp_rtc_elapsed_ms(rtc_before, lp_rtc_ticks());
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uwTick += slept_ms;
+	TIM2->CNT += slept_ms * 1000U;
+	__set_PRIMASK(primask);
+	ready_ts += slept_ms * 1000U;
+	scheduler_resync();
+
+	lowpower_wake_t why = (pending & LOWPOWER_CAN_EXTI) ? LOWPOWER_WAKE_CAN :
+	                      (pending & LOWPOWER_RTC_EXTI) ? LOWPOWER_WAKE_RTC : LOWPOWER_WAKE_OTHER;
+	lowpower_stats.wakes[why]++;
+	lowpower_stats.asleep_ms += slept_ms;
+	lowpower_stats.wake_us_last = lp_wake_us;
+	if (lp_wake_us > lowpower_stats.wake_us_max){
+		lowpower_stats.wake_us_max = lp_wake_us;
+	}
+	if (why == LOWPOWER_WAKE_CAN){
+		lp_first_pending = true;
+		lp_wake_ready_ts = ready_ts;
+		TRACE(LOWPOWER_CAN_WAKE, slept_ms, lp_wake_us);
+	}
+	lp_awake_since = HAL_GetTick();
+	lp_slept = true;
+}
+
+/* The rings were empty at STOP, so the oldest unread frame of either is the first since the wake */
+static void lp_first_frame(void){
+	const can_frame_t *f = CANRingBuffer_Peek(&can_rb);
+	const can_frame_t *p = CANRingBuffer_Peek(&can_rb_priority);
+	if ((p != NULL) && ((f == NULL) || ((int32_t)(p->timestamp - f->timestamp) < 0))){
+		f = p;
+	}
+	if (f == NULL){
+		if ((HAL_GetTick() - lp_awake_since) >= LOWPOWER_FIRST_FRAME_MS){
+			lp_first_pending = false;
+			lowpower_stats.no_frame++;
+		}
+		return;
+	}
+	lp_first_pending = false;
+	uint32_t us = lp_wake_us + (f->timestamp - lp_wake_ready_ts);
+	lowpower_stats.first_frame_us_last = us;
+	if (us > lowpower_stats.first_frame_us_max){
+		lowpower_stats.first_frame_us_max = us;
+	}
+	TRACE(LOWPOWER_FIRST_FRAME, us, f->id);
+}
+
+void lowpower_update(sys_state_t state){
+	if (lp_first_pending){
+		lp_first_frame();
+	}
+	uint32_t now = HAL_GetTick();
+	if (state != SYS_IDLE){
+		lp_idle_since = now;
+		lp_slept = false;
+		return;
+	}
+#if LOWPOWER_ENABLE
+	if (lp_slept ? ((now - lp_awake_since) >= LOWPOWER_AWAKE_MS) : ((now - lp_idle_since) >= LOWPOWER_IDLE_DELAY_MS)){
+		lowpower_stop();
+	}
+#endif
+}
+
+void lowpower_dump(void){
+	char line[128];
+	snprintf(line, sizeof(line), "---- power: %lu stops (%lu aborted), %lu ms asleep ----\r\n",
+	         (unsigned long)lowpower_stats.stops, (unsigned long)lowpower_stats.aborted,
+	         (unsigned long)lowpower_stats.asleep_ms);
+	DBG_Print(line);
+	snprintf(line, sizeof(line), "wakes can=%lu rtc=%lu other=%lu, can with no frame=%lu\r\n",
+	         (unsigned long)lowpower_stats.wakes[LOWPOWER_WAKE_CAN], (unsigned long)lowpower_stats.wakes[LOWPOWER_WAKE_RTC],
+	         (unsigned long)lowpower_stats.wakes[LOWPOWER_WAKE_OTHER], (unsigned long)lowpower_stats.no_frame);
+	DBG_Print(line);
+	snprintf(line, sizeof(line), "wake to CAN on bus last=%lu max=%lu us, wake to first frame last=%lu max=%lu us\r\n",
+	         (unsigned long)lowpower_stats.wake_us_last, (unsigned long)lowpower_stats.wake_us_max,
+	         (unsigned long)lowpower_stats.first_frame_us_last, (unsigned long)lowpower_stats.first_frame_us_max);
+	DBG_Print(line);
+}
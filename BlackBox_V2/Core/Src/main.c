@@ -28,11 +28,23 @@
 #include "gpio.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "dma_streams.h"
 #include "imu.h"
 #include "can_handler.h"
+#include "can_filter.h"
 #include "sd_logger.h"
 #include "fsm_sys.h"
 #include "fault.h"
+#include "timebase.h"
+#include "gps_driver.h"
+#include "timesync.h"
+#include "scheduler.h"
+#include "tasks.h"
+#include "prof.h"
+#include "trace.h"
+#include "clock_profile.h"
+#include "lowpower.h"
+#include "crash.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -94,6 +106,8 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  /* DMA clocks/IRQs must be up before SPI1 links its streams in HAL_SPI_MspInit; not CubeMX-generated, see dma_streams.c */
+  dma_streams_init();
 
   /* USER CODE END SysInit */
 
@@ -112,6 +126,11 @@ int main(void)
   /* USER CODE BEGIN 2 */
 
   MX_USART2_UART_Init();
+  trace_init(); // DBG_Print AND TRACE QUEUE FROM HERE ON; USART2 TX DMA DRAINS THEM, tools/trace_decode.py FORMATS
+  crash_init(); // RESET CAUSE AND THE LAST RUN'S BACKUP SRAM RECORD, LOGGED BY THE FIRST SESSION
+
+  timebase_init(); // 1 MHz TIM2 FOR CAN/IMU/GPS TIMESTAMPS, BEFORE ANY SOURCE STARTS
+  prof_init(); // DWT CYCLE COUNTER FOR THE HOT-PATH PROBES, BEFORE THE FIRST CAN INTERRUPT
 
   can_handler_init(); // CURRENTLY DOES NOT HAVE ANYTHING THAT SHOWS IT HAS SUCCEEDED COME BACK LATER TO FIX
 
@@ -120,6 +139,9 @@ int main(void)
   peripherals_init &= sd_mount;
 
   imu_init(); // IMU INIT
+
+  GPS_Driver_Init(); // UART4 CIRCULAR DMA; UBX SETUP AND PARSING RUN IN GPS_Driver_Update
+  timesync_init(); // PPS CAPTURE ON TIM2_CH1 (PA15), LABELLED WITH UTC FROM GPS TIME MESSAGES
   /* Session files are opened by SYS_FSM on first CAN frame (SYS_IDLE -> SYS_LOGGING) */
 
   CAN_TxHeaderTypeDef tx_header;
@@ -133,19 +155,15 @@ int main(void)
   HAL_CAN_AddTxMessage(&hcan1, &tx_header, tx_data, &tx_mailbox);
 
   /* TEMP: USART2 IMU monitor. Remove with MX_USART2_UART_Init when done. */
-  {
-    char line[128];
-    DBG_Print("\r\n======== IMU USART2 TEST ========\r\n");
-    DBG_Print("115200 8N1  |  tilt the board; sitting still after cal should be near 0\r\n");
-    snprintf(line, sizeof(line), "WHO_AM_I=0x%02X (want 0x68)  imu_fault=%u handshake_fault=%u\r\n",
-             imu_who_am_i,
-             (unsigned)fault_flags.imu_fault,
-             (unsigned)fault_flags.imu_handshake_fault);
-    DBG_Print(line);
-    snprintf(line, sizeof(line), "offsets ax=%d ay=%d az=%d\r\n",
-             imu_offset.offset_x, imu_offset.offset_y, imu_offset.offset_z);
-    DBG_Print(line);
-  }
+  DBG_Print("\r\n======== IMU USART2 TEST ========\r\n");
+  DBG_Print("115200 8N1  |  tilt the board; sitting still after cal should be near 0\r\n");
+  TRACE(BOOT_IMU, imu_who_am_i, fault_flags.imu_fault, fault_flags.imu_handshake_fault);
+  TRACE(BOOT_IMU_OFFSETS, imu_offset.offset_x, imu_offset.offset_y, imu_offset.offset_z);
+  TRACE(BOOT_CAN_FILTERS, can_filter_banks_used, CAN_FILTER_BANKS);
+
+  clock_profile_init(); // BOOTS IN THE LOGGING PROFILE; THE LOGGER TASK SWITCHES ON FSM STATE AND CAN LOAD
+  lowpower_init(); // STOP MODE IN SYS_IDLE, WOKEN BY A CAN RX EDGE OR THE RTC
+  scheduler_init(app_tasks, TASK_COUNT); // RELEASES START FROM HERE; THE HEALTH TASK OWNS THE IWDG REFRESH
 
   /* USER CODE END 2 */
 
@@ -153,27 +171,7 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	  SYS_FSM_TICK();
-	  CAN_Handler_RecoverBusOff();
-
-	  /* TEMP: print IMU at 5 Hz */
-	  {
-		  static uint32_t last_imu_print = 0;
-		  uint32_t now = HAL_GetTick();
-		  if ((now - last_imu_print) >= 200U) {
-			  char line[128];
-			  imu_read();
-			  snprintf(line, sizeof(line), "t=%lu  ax=%d ay=%d az=%d  f=%u hs=%u\r\n",
-			           (unsigned long)imu.timestamp,
-			           imu.accel_x, imu.accel_y, imu.accel_z,
-			           (unsigned)fault_flags.imu_fault,
-			           (unsigned)fault_flags.imu_handshake_fault);
-			  DBG_Print(line);
-			  last_imu_print = now;
-		  }
-	  }
-
-	  HAL_IWDG_Refresh(&hiwdg);
+	  scheduler_run(); // NEVER RETURNS; CAN, IMU, GPS, LOGGER, SD, UI AND HEALTH RUN FROM app_tasks
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -193,7 +191,7 @@ void SystemClock_Config(void)
   /** Configure the main internal regulator output voltage
   */
   __HAL_RCC_PWR_CLK_ENABLE();
-  __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE3);
+  __HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE1);
 
   /** Initializes the RCC Oscillators according to the specified parameters
   * in the RCC_OscInitTypeDef structure.
@@ -207,7 +205,7 @@ void SystemClock_Config(void)
   RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
   RCC_OscInitStruct.PLL.PLLM = 8;
   RCC_OscInitStruct.PLL.PLLN = 180;
-  RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV4;
+  RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV2;
   RCC_OscInitStruct.PLL.PLLQ = 2;
   RCC_OscInitStruct.PLL.PLLR = 2;
   if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
@@ -215,12 +213,19 @@ void SystemClock_Config(void)
     Error_Handler();
   }
 
+  /** Activate the Over-Drive mode
+  */
+  if (HAL_PWREx_EnableOverDrive() != HAL_OK)
+  {
+    Error_Handler();
+  }
+
   /** Initializes the CPU, AHB and APB buses clocks
   */
   RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK
                               |RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
   RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV2;
   RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV2;
   RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
 
@@ -241,11 +246,8 @@ void SystemClock_Config(void)
 void Error_Handler(void)
 {
   /* USER CODE BEGIN Error_Handler_Debug */
-  /* User can add his own implementation to report the HAL error return state */
-  __disable_irq();
-  while (1)
-  {
-  }
+  /* Caller and ring state go to backup SRAM, then a reset; the next boot logs them */
+  crash_error_handler((uint32_t)__builtin_return_address(0));
   /* USER CODE END Error_Handler_Debug */
 }
 #ifdef USE_FULL_ASSERT
@@ -0,0 +1,412 @@
+/*
+ * nmea_parser.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// SINGLE-PASS NMEA 0183 PARSER: ONE BYTE AT A TIME, INTEGER MATH, NO BUFFERED SENTENCE
+
+#include "nmea_parser.h"
+#include <string.h>
+
+enum {
+	NMEA_ST_IDLE,		// WAITING FOR '$'
+	NMEA_ST_BODY,		// FIELDS UP TO '*'
+	NMEA_ST_CK1,		// CHECKSUM HIGH NIBBLE
+	NMEA_ST_CK2			// CHECKSUM LOW NIBBLE
+};
+
+/* stage_mask bits: which fields of the current sentence parsed cleanly */
+#define S_LAT     0x0001
+#define S_LON     0x0002
+#define S_ALT     0x0004
+#define S_SPEED   0x0008
+#define S_COURSE  0x0010
+#define S_TIME    0x0020
+#define S_DATE    0x0040
+#define S_HDOP    0x0080
+#define S_QUALITY 0x0100
+#define S_FIXTYPE 0x0200
+#define S_SATS    0x0400
+#define S_STATUS  0x0800
+
+#define KNOTS_TO_MMPH 1852000ULL	// LARGEST field_scaled MULTIPLIER
+
+/* mantissa * mul in field_scaled must fit uint64; the widest real field (dddmm.mmmmmmm) is under 2e11 */
+#if NMEA_MANTISSA_MAX > (0xFFFFFFFFFFFFFFFFULL - 3600ULL * 10000000ULL) / KNOTS_TO_MMPH
+#error "NMEA_MANTISSA_MAX too large for field_scaled"
+#endif
+
+static const uint32_t pow10_tab[NMEA_MAX_FRAC + 1] = {
+	1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL
+};
+
+static void field_reset(nmea_parser_t *p){
+	p->mantissa = 0;
+	p->frac_digits = 0;
+	p->has_digits = false;
+	p->seen_point = false;
+	p->negative = false;
+	p->bad = false;
+	p->letter = 0;
+}
+
+static void sentence_reset(nmea_parser_t *p){
+	p->state = NMEA_ST_BODY;
+	p->sentence = 0;
+	p->field = 0;
+	p->length = 1;
+	p->checksum = 0;
+	p->type_len = 0;
+	p->stage_mask = 0;
+	p->hemi_lat = 0;
+	p->hemi_lon = 0;
+	field_reset(p);
+}
+
+void nmea_init(nmea_parser_t *p){
+	memset(p, 0, sizeof(*p));
+	p->state = NMEA_ST_IDLE;
+}
+
+static bool field_number(const nmea_parser_t *p){
+	return p->has_digits && !p->bad;
+}
+
+/* mantissa / 10^frac * mul / div, rounded to nearest */
+static int64_t field_scaled(const nmea_parser_t *p, uint32_t mul, uint32_t div){
+	uint64_t den = (uint64_t)pow10_tab[p->frac_digits] * div;
+	int64_t v = (int64_t)((p->mantissa * mul + den / 2) / den);
+	return p->negative ? -v : v;
+}
+
+/* [d]ddmm.mmmm -> 1e-7 degrees */
+static bool field_coord(const nmea_parser_t *p, uint32_t max_deg, int32_t *out){
+	if (!field_number(p) || p->negative){
+		return false;
+	}
+	uint64_t den = pow10_tab[p->frac_digits];
+	uint64_t whole = p->mantissa / den;
+	uint64_t deg = whole / 100;
+	uint64_t minutes = (whole % 100) * den + (p->mantissa % den); // MINUTES x 10^frac
+	if ((deg > max_deg) || (minutes >= 60 * den) || ((deg == max_deg) && (minutes != 0))){
+		return false;
+	}
+	*out = (int32_t)(deg * 10000000ULL + (minutes * 10000000ULL + 30 * den) / (60 * den));
+	return true;
+}
+
+/* hhmmss[.sss] -> milliseconds of day */
+static bool field_time(const nmea_parser_t *p, uint32_t *out){
+	if (!field_number(p)){
+		return false;
+	}
+	uint64_t den = pow10_tab[p->frac_digits];
+	uint64_t whole = p->mantissa / den;
+	uint32_t hh = (uint32_t)(whole / 10000);
+	uint32_t mm = (uint32_t)((whole / 100) % 100);
+	uint32_t ss = (uint32_t)(whole % 100);
+	if ((hh > 23) || (mm > 59) || (ss > 60)){
+		return false;
+	}
+	*out = ((hh * 60 + mm) * 60 + ss) * 1000 + (uint32_t)(((p->mantissa % den) * 1000) / den);
+	return true;
+}
+
+static void set_speed_knots(nmea_parser_t *p){
+	if (field_number(p)){
+		p->stage.speed_mmps = (int32_t)field_scaled(p, KNOTS_TO_MMPH, 3600UL); // 1 KN = 1852 M/H
+		p->stage_mask |= S_SPEED;
+	}
+}
+
+static void set_course(nmea_parser_t *p){
+	if (field_number(p)){
+		p->stage.course_cdeg = (int32_t)field_scaled(p, 100, 1);
+		p->stage_mask |= S_COURSE;
+	}
+}
+
+static void set_time(nmea_parser_t *p){
+	if (field_time(p, &p->stage.time_ms)){
+		p->stage_mask |= S_TIME;
+	}
+}
+
+static void set_lat(nmea_parser_t *p){
+	if (field_coord(p, 90, &p->stage.lat_e7)){
+		p->stage_mask |= S_LAT;
+	}
+}
+
+static void set_lon(nmea_parser_t *p){
+	if (field_coord(p, 180, &p->stage.lon_e7)){
+		p->stage_mask |= S_LON;
+	}
+}
+
+/* $--RMC,time,status,lat,N/S,lon,E/W,knots,course,ddmmyy,... */
+static void rmc_field(nmea_parser_t *p){
+	switch (p->field){
+	case 1: set_time(p); break;
+	case 2:
+		p->stage.rmc_valid = (p->letter == 'A');
+		p->stage_mask |= S_STATUS;
+		break;
+	case 3: set_lat(p); break;
+	case 4: p->hemi_lat = p->letter; break;
+	case 5: set_lon(p); break;
+	case 6: p->hemi_lon = p->letter; break;
+	case 7: set_speed_knots(p); break;
+	case 8: set_course(p); break;
+	case 9:
+		if (field_number(p) && (p->frac_digits == 0)){
+			p->stage.date = (uint32_t)p->mantissa;
+			p->stage_mask |= S_DATE;
+		}
+		break;
+	default: break;
+	}
+}
+
+/* $--GGA,time,lat,N/S,lon,E/W,quality,sats,hdop,alt,M,... */
+static void gga_field(nmea_parser_t *p){
+	switch (p->field){
+	case 1: set_time(p); break;
+	case 2: set_lat(p); break;
+	case 3: p->hemi_lat = p->letter; break;
+	case 4: set_lon(p); break;
+	case 5: p->hemi_lon = p->letter; break;
+	case 6:
+		if (field_number(p)){
+			p->stage.quality = (uint8_t)p->mantissa;
+			p->stage_mask |= S_QUALITY;
+		}
+		break;
+	case 7:
+		if (field_number(p)){
+			p->stage.sats = (uint8_t)p->mantissa;
+			p->stage_mask |= S_SATS;
+		}
+		break;
+	case 8:
+		if (field_number(p)){
+			p->stage.hdop_c = (uint16_t)field_scaled(p, 100, 1);
+			p->stage_mask |= S_HDOP;
+		}
+		break;
+	case 9:
+		if (field_number(p)){
+			p->stage.alt_mm = (int32_t)field_scaled(p, 1000, 1);
+			p->stage_mask |= S_ALT;
+		}
+		break;
+	default: break;
+	}
+}
+
+/* $--VTG,course,T,course_mag,M,knots,N,kph,K[,mode] */
+static void vtg_field(nmea_parser_t *p){
+	switch (p->field){
+	case 1: set_course(p); break;
+	case 7:
+		if (field_number(p)){
+			p->stage.speed_mmps = (int32_t)field_scaled(p, 1000000UL, 3600UL);
+			p->stage_mask |= S_SPEED;
+		}
+		break;
+	default: break;
+	}
+}
+
+/* $--GSA,mode,fix_type,prn x12,pdop,hdop,vdop */
+static void gsa_field(nmea_parser_t *p){
+	if ((p->field == 2) && field_number(p)){
+		p->stage.fix_type = (uint8_t)p->mantissa;
+		p->stage_mask |= S_FIXTYPE;
+	}
+	else if ((p->field == 16) && field_number(p)){
+		p->stage.hdop_c = (uint16_t)field_scaled(p, 100, 1);
+		p->stage_mask |= S_HDOP;
+	}
+}
+
+/* Any talker ("GP", "GN", "GL"...) is accepted; the formatter picks the sentence */
+static uint8_t sentence_type(const nmea_parser_t *p){
+	if (p->type_len != 5){
+		return 0;
+	}
+	const char *f = &p->type[2];
+	if (memcmp(f, "RMC", 3) == 0) return NMEA_RMC;
+	if (memcmp(f, "GGA", 3) == 0) return NMEA_GGA;
+	if (memcmp(f, "VTG", 3) == 0) return NMEA_VTG;
+	if (memcmp(f, "GSA", 3) == 0) return NMEA_GSA;
+	return 0;
+}
+
+static void field_done(nmea_parser_t *p){
+	if (p->field == 0){
+		p->sentence = sentence_type(p);
+	}
+	else if (!p->bad){
+		switch (p->sentence){
+		case NMEA_RMC: rmc_field(p); break;
+		case NMEA_GGA: gga_field(p); break;
+		case NMEA_VTG: vtg_field(p); break;
+		case NMEA_GSA: gsa_field(p); break;
+		default: break;
+		}
+	}
+	p->field++;
+	field_reset(p);
+}
+
+static void field_char(nmea_parser_t *p, uint8_t c){
+	if (p->field == 0){
+		if (p->type_len < sizeof(p->type)){
+			p->type[p->type_len++] = (char)c;
+		}
+		return;
+	}
+	if ((c >= '0') && (c <= '9')){
+		if (p->bad){
+			return; // ALREADY REJECTED: STOP BEFORE THE MANTISSA WRAPS
+		}
+		if (p->seen_point){
+			if (p->frac_digits >= NMEA_MAX_FRAC){
+				return;
+			}
+			p->frac_digits++;
+		}
+		p->mantissa = p->mantissa * 10 + (c - '0');
+		p->has_digits = true;
+		if (p->mantissa > NMEA_MANTISSA_MAX){
+			p->bad = true;
+		}
+	}
+	else if (c == '.'){
+		p->bad |= p->seen_point;
+		p->seen_point = true;
+	}
+	else if ((c == '-') && !p->has_digits && !p->seen_point){
+		p->negative = true;
+	}
+	else if (p->letter == 0){
+		p->letter = (char)c;
+	}
+	else{
+		p->bad = true;
+	}
+}
+
+/* Checksum passed: merge what this sentence carried, position only with a valid fix */
+static uint8_t sentence_commit(nmea_parser_t *p, gps_fix_t *fix){
+	const gps_fix_t *s = &p->stage;
+	uint16_t m = p->stage_mask;
+	bool fix_ok;
+
+	switch (p->sentence){
+	case NMEA_RMC: fix_ok = (m & S_STATUS) && s->rmc_valid; break;
+	case NMEA_GGA: fix_ok = (m & S_QUALITY) && (s->quality > 0); break;
+	default: fix_ok = true; break;
+	}
+
+	if (m & S_STATUS) fix->rmc_valid = s->rmc_valid;
+	if (m & S_QUALITY) fix->quality = s->quality;
+	if (m & S_SATS) fix->sats = s->sats;
+	if (m & S_HDOP) fix->hdop_c = s->hdop_c;
+	if (m & S_FIXTYPE) fix->fix_type = s->fix_type;
+	if (m & S_TIME) fix->time_ms = s->time_ms;
+	if (m & S_DATE) fix->date = s->date;
+
+	if (fix_ok){
+		bool lat_ok = (m & S_LAT) && ((p->hemi_lat == 'N') || (p->hemi_lat == 'S'));
+		bool lon_ok = (m & S_LON) && ((p->hemi_lon == 'E') || (p->hemi_lon == 'W'));
+		if (lat_ok && lon_ok){
+			fix->lat_e7 = (p->hemi_lat == 'S') ? -s->lat_e7 : s->lat_e7;
+			fix->lon_e7 = (p->hemi_lon == 'W') ? -s->lon_e7 : s->lon_e7;
+		}
+		if (m & S_ALT) fix->alt_mm = s->alt_mm;
+		if (m & S_SPEED) fix->speed_mmps = s->speed_mmps;
+		if (m & S_COURSE) fix->course_cdeg = s->course_cdeg;
+	}
+	return p->sentence;
+}
+
+static int hex_value(uint8_t c){
+	if ((c >= '0') && (c <= '9')) return c - '0';
+	if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+	if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+	return -1;
+}
+
+uint8_t nmea_feed(nmea_parser_t *p, uint8_t c, gps_fix_t *fix){
+	if (c == '$'){
+		if (p->state != NMEA_ST_IDLE){
+			p->errors++; // TRUNCATED SENTENCE
+		}
+		sentence_reset(p);
+		return 0;
+	}
+
+	switch (p->state){
+	case NMEA_ST_BODY:
+		if (++p->length > NMEA_MAX_LEN){
+			p->errors++;
+			p->state = NMEA_ST_IDLE;
+		}
+		else if (c == '*'){
+			field_done(p);
+			p->state = NMEA_ST_CK1;
+		}
+		else if ((c == '\r') || (c == '\n')){
+			p->errors++; // NO CHECKSUM: NEVER TRUSTED
+			p->state = NMEA_ST_IDLE;
+		}
+		else{
+			p->checksum ^= c;
+			if (c == ','){
+				field_done(p);
+			}
+			else{
+				field_char(p, c);
+			}
+		}
+		break;
+
+	case NMEA_ST_CK1: {
+		int v = hex_value(c);
+		if (v < 0){
+			p->errors++;
+			p->state = NMEA_ST_IDLE;
+			break;
+		}
+		p->checksum_rx = (uint8_t)(v << 4);
+		p->state = NMEA_ST_CK2;
+		break;
+	}
+
+	case NMEA_ST_CK2: {
+		int v = hex_value(c);
+		p->state = NMEA_ST_IDLE;
+		if ((v < 0) || ((p->checksum_rx | (uint8_t)v) != p->checksum)){
+			p->errors++;
+			break;
+		}
+		return (p->sentence != 0) ? sentence_commit(p, fix) : 0;
+	}
+
+	default:
+		break; // IDLE: NOISE BETWEEN SENTENCES
+	}
+	return 0;
+}
+
+uint8_t nmea_feed_span(nmea_parser_t *p, const uint8_t *data, uint16_t len, gps_fix_t *fix){
+	uint8_t done = 0;
+	for (uint16_t i = 0; i < len; i++){
+		done |= nmea_feed(p, data[i], fix);
+	}
+	return done;
+}
@@ -0,0 +1,105 @@
+/*
+ * prof.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// DWT CYCLE PROBES: MIN/MAX/MEAN AND LOG2 HISTOGRAM PER NAMED HOT PATH
+
+#include "prof.h"
+
+#if PROF_ENABLE
+
+#include "usart.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *const prof_names[PROF_COUNT] = {
+#define PROF_NAME(id, name) name,
+	PROF_PROBES(PROF_NAME)
+#undef PROF_NAME
+};
+
+static prof_stats_t prof_stats[PROF_COUNT];
+
+void prof_init(void){
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	prof_reset();
+}
+
+/* Each probe has one writer (an ISR or the main loop), so no lock is needed here */
+void prof_record(prof_id_t id, uint32_t cycles){
+	prof_stats_t *p = &prof_stats[id];
+	if ((p->count == 0) || (cycles < p->min)){
+		p->min = cycles;
+	}
+	if (cycles > p->max){
+		p->max = cycles;
+	}
+	p->count++;
+	p->sum += cycles;
+	p->hist[(cycles != 0) ? (31 - __CLZ(cycles)) : 0]++;
+}
+
+void prof_snapshot(prof_id_t id, prof_stats_t *out, bool clear){
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	*out = prof_stats[id];
+	if (clear){
+		memset(&prof_stats[id], 0, sizeof(prof_stats[id]));
+	}
+	__set_PRIMASK(primask);
+}
+
+void prof_reset(void){
+	prof_stats_t discard;
+	for (int i = 0; i < PROF_COUNT; i++){
+		prof_snapshot((prof_id_t)i, &discard, true);
+	}
+}
+
+const char *prof_name(prof_id_t id){
+	return prof_names[id];
+}
+
+static uint32_t cycles_us(uint64_t cycles){
+	return (uint32_t)(cycles / (SystemCoreClock / 1000000U));
+}
+
+void prof_dump(void){
+	char line[160];
+	snprintf(line, sizeof(line), "---- prof @ %lu MHz: probes since the last log record or reset, tasks since boot ----\r\n",
+	         (unsigned long)(SystemCoreClock / 1000000U));
+	DBG_Print(line);
+	for (int i = 0; i < PROF_COUNT; i++){
+		prof_stats_t s;
+		prof_snapshot((prof_id_t)i, &s, false);
+		uint32_t mean = (s.count != 0) ? (uint32_t)(s.sum / s.count) : 0;
+		int n = snprintf(line, sizeof(line), "%-12s n=%lu min=%lu max=%lu mean=%lu cyc (max %lu us) |",
+		                 prof_names[i], (unsigned long)s.count, (unsigned long)s.min,
+		                 (unsigned long)s.max, (unsigned long)mean, (unsigned long)cycles_us(s.max));
+		for (int b = 0; (b < PROF_BINS) && (n < (int)sizeof(line) - 16); b++){
+			if (s.hist[b] != 0){
+				n += snprintf(line + n, sizeof(line) - n, " %d:%lu", b, (unsigned long)s.hist[b]); // LOG2 BIN:COUNT
+			}
+		}
+		snprintf(line + n, sizeof(line) - n, "\r\n");
+		DBG_Print(line);
+	}
+
+	/* Scheduler view of the same interval: which task overran or started late */
+	for (uint8_t i = 0; i < scheduler_task_count(); i++){
+		const sched_task_t *t = scheduler_task(i);
+		const sched_stats_t *s = scheduler_stats(i);
+		snprintf(line, sizeof(line), "task %-8s runs=%lu over=%lu late=%lu skip=%lu max=%lu us jitter=%lu us\r\n",
+		         t->name, (unsigned long)s->runs, (unsigned long)s->overruns, (unsigned long)s->late,
+		         (unsigned long)s->skipped, (unsigned long)scheduler_cycles_to_us(s->max_cycles),
+		         (unsigned long)s->max_jitter_us);
+		DBG_Print(line);
+	}
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * scheduler.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// STATIC TASK TABLE DISPATCHER: PERIODIC RELEASES, CYCLE BUDGETS, JITTER AND CHECK-IN TRACKING
+
+#include "scheduler.h"
+#include "main.h"
+#include "timebase.h"
+#include "crash.h"
+#include <string.h>
+
+static const sched_task_t *sched_tasks = NULL;
+static uint8_t sched_count = 0;
+static sched_stats_t sched_stats[SCHED_MAX_TASKS];
+static uint32_t sched_cycles_per_us = 1;
+
+void scheduler_clock_update(void){
+	sched_cycles_per_us = SystemCoreClock / 1000000U;
+	if (sched_cycles_per_us == 0){
+		sched_cycles_per_us = 1;
+	}
+}
+
+void scheduler_init(const sched_task_t *tasks, uint8_t count){
+	if (count > SCHED_MAX_TASKS){
+		count = SCHED_MAX_TASKS;
+	}
+	sched_tasks = tasks;
+	sched_count = count;
+	memset(sched_stats, 0, sizeof(sched_stats));
+
+	/* DWT cycle counter for run-time measurement */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	scheduler_clock_update();
+
+	uint32_t now = timebase_now_us();
+	for (uint8_t i = 0; i < count; i++){
+		sched_stats[i].next_release = now + tasks[i].offset_us;
+		sched_stats[i].last_start = now; // THE CHECK-IN WINDOW OPENS HERE
+	}
+}
+
+/*
+ * The timebase stood still or jumped (STOP mode): release every task afresh on
+ * its offset instead of booking the gap as late starts and skipped periods.
+ * The sleeper kept the watchdog fed, so the gap counts as a check-in.
+ */
+void scheduler_resync(void){
+	uint32_t now = timebase_now_us();
+	for (uint8_t i = 0; i < sched_count; i++){
+		sched_stats[i].next_release = now + sched_tasks[i].offset_us;
+		sched_stats[i].last_start = now;
+	}
+}
+
+uint32_t scheduler_cycles_to_us(uint32_t cycles){
+	return cycles / sched_cycles_per_us;
+}
+
+static void sched_execute(uint8_t i, uint32_t now){
+	const sched_task_t *task = &sched_tasks[i];
+	sched_stats_t *st = &sched_stats[i];
+
+	uint32_t jitter = now - st->next_release;
+	st->last_jitter_us = jitter;
+	if (jitter > st->max_jitter_us){
+		st->max_jitter_us = jitter;
+	}
+	if (jitter > task->deadline_us){
+		st->late++;
+	}
+
+	/* Next release stays on the period grid; releases already missed are dropped, not bunched */
+	st->next_release += task->period_us;
+	if ((int32_t)(now - st->next_release) >= 0){
+		uint32_t behind = (now - st->next_release) / task->period_us + 1;
+		st->skipped += behind;
+		st->next_release += behind * task->period_us;
+	}
+
+	st->last_start = now;
+	uint32_t start = DWT->CYCCNT;
+	crash_task(i); // A FAULT OR A WATCHDOG RESET NAMES THIS TASK
+	task->run();
+	crash_task(CRASH_NO_TASK);
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	st->runs++;
+	st->last_cycles = cycles;
+	if (cycles > st->max_cycles){
+		st->max_cycles = cycles;
+	}
+	if (cycles > task->budget_us * sched_cycles_per_us){
+		st->overruns++;
+	}
+}
+
+bool scheduler_dispatch(void){
+	uint32_t now = timebase_now_us();
+	for (uint8_t i = 0; i < sched_count; i++){
+		if ((int32_t)(now - sched_stats[i].next_release) >= 0){
+			sched_execute(i, now);
+			return true; // RESCAN FROM THE TOP: A HIGHER-PRIORITY TASK MAY HAVE COME DUE
+		}
+	}
+	return false;
+}
+
+void scheduler_run(void){
+	for (;;){
+		if (!scheduler_dispatch()){
+			__WFI(); // SYSTICK OR ANY PERIPHERAL INTERRUPT WAKES THE NEXT SCAN
+		}
+	}
+}
+
+/*
+ * Each task is judged on its own clock: it has checked in if it started within
+ * one period plus its deadline, the latest a healthy release can start. A 200 ms
+ * task then passes every 100 ms health check, not one in two.
+ */
+bool scheduler_check_in_all(void){
+	uint32_t now = timebase_now_us();
+	for (uint8_t i = 0; i < sched_count; i++){
+		if ((now - sched_stats[i].last_start) > (sched_tasks[i].period_us + sched_tasks[i].deadline_us)){
+			return false;
+		}
+	}
+	return true;
+}
+
+const sched_stats_t *scheduler_stats(uint8_t index){
+	return (index < sched_count) ? &sched_stats[index] : NULL;
+}
+
+const sched_task_t *scheduler_task(uint8_t index){
+	return (index < sched_count) ? &sched_tasks[index] : NULL;
+}
+
+uint8_t scheduler_task_count(void){
+	return sched_count;
+}
@@ -11,7 +11,21 @@
 #include "main.h"
 #include "can_handler.h"
 #include <stdio.h>
+#include <string.h>
 #include "imu.h"
+#include "imu_filter.h"
+#include "sd_logger.h"
+#include "log_format.h"
+#include "timebase.h"
+#include "log_policy.h"
+#include "can_decode.h"
+#include "imu_cal.h"
+#include "gps_driver.h"
+#include "timesync.h"
+#include "dead_reckon.h"
+#include "prof.h"
+#include "trace.h"
+#include "crash.h"
 
 FATFS fs;
 FIL log_file;
@@ -23,10 +37,407 @@ volatile bool sd_mount = false;
 
 // timer for faster imu polls
 static uint32_t last_row_write_time = 0;
+static uint32_t last_skip_summary_time = 0;
+
+/*
+ * Rows are staged here and handed to FatFs only while the card is idle, so a
+ * card busy period (GC pauses run 100+ ms) turns into buffering instead of a
+ * stall in task_sd. Each f_write ends on a sector boundary of the file, so
+ * FatFs passes it straight to USER_write as CMD25 instead of copying through its
+ * window; only the age and close paths write a partial sector.
+ */
+#define SD_STAGE_SIZE    16384	// ~1 S OF 1 kHz IMU + CAN THROUGH A CARD BUSY PERIOD
+#define SD_ROW_MAX       96		// LONGEST CSV ROW WITH MARGIN, > BBX_REC_MAX_SIZE
+#define SD_SECTOR_BYTES  512
+#define SD_FLUSH_BYTES   (SD_WRITE_BURST_MAX * SD_SECTOR_BYTES)	// ONE CMD25 BURST PER f_write, THE MOST ONE CALL MAY TAKE
+#define SD_FLUSH_AGE_MS  250	// BOUND LATENCY WHEN THE BUS IS QUIET
+
+#define SD_PROF_PERIOD_MS 10000	// ONE PROF RECORD PER PROBE PER INTERVAL
+#define SD_PROF_ROW_MAX   (1 + 4 + 4 + 1 + PROF_NAME_MAX + 16 + 2 + 4 * PROF_BINS)
+static uint32_t last_prof_time = 0;
+
+/* GPS fixes join the merge below in time order; the last one handled */
+static uint32_t merged_gps_seq = 0;
+
+/* IMU samples reach the ring in bursts and leave the filter late; hold newer CAN frames this long */
+#define SD_IMU_REORDER_US (25000 + IMU_FILTER_DELAY_US)
+
+static char stage_buffer[SD_STAGE_SIZE];
+static int stage_len = 0;
+static uint32_t last_flush_time = 0;
+static uint32_t stage_dropped_bytes = 0;	// STAGED BUT NEVER WRITTEN, SINCE BOOT
+
+/* Discard everything staged after an SD error */
+static void stage_drop(void){
+	stage_dropped_bytes += (uint32_t)stage_len;
+	stage_len = 0;
+}
+
+/* Hand the first len staged bytes to FatFs and move the rest to the front */
+static void stage_write(int len){
+	UINT bytes_written = 0;
+	FRESULT verify = f_write(&log_file, stage_buffer, len, &bytes_written);
+	if (verify != FR_OK){
+		fault_flags.sd_fault = true;
+		stage_drop(); // UP TO SD_STAGE_SIZE LOST; SYS_LOGGING THEN ABORTS THE SESSION AND REMOUNTS
+		return;
+	}
+	stage_len -= len;
+	memmove(stage_buffer, stage_buffer + len, stage_len);
+}
+
+/*
+ * Whole sectors of the file, at most SD_FLUSH_BYTES per call, so a backlog after
+ * a card busy period drains over several task_sd runs. With tail set the partial
+ * last sector goes too once the rest fits in one call.
+ */
+static void stage_flush(bool tail){
+	int head = (int)((SD_SECTOR_BYTES - (f_tell(&log_file) % SD_SECTOR_BYTES)) % SD_SECTOR_BYTES); // TO THE NEXT BOUNDARY
+	int limit = head + ((SD_FLUSH_BYTES - head) & ~(SD_SECTOR_BYTES - 1));
+	int len = (stage_len >= head) ? (head + ((stage_len - head) & ~(SD_SECTOR_BYTES - 1))) : 0;
+
+	if (tail && (stage_len <= limit)){
+		len = stage_len;
+	}
+	if (len > limit){
+		len = limit;
+	}
+	if (len > 0){
+		stage_write(len);
+	}
+	if (tail || (len > 0)){
+		last_flush_time = HAL_GetTick();
+	}
+}
+
+/* Everything, for the close path */
+static void stage_flush_all(void){
+	while (stage_len > 0){
+		stage_flush(true);
+	}
+}
+
+#if SD_LOG_BINARY
+/* Encoder state for the .bbx record stream, reset per session */
+static uint32_t bbx_last_ts = 0;
+static bool bbx_imu_valid = false;
+static uint32_t bbx_sync_seq = 0;
+static int16_t bbx_imu_x, bbx_imu_y, bbx_imu_z;
+
+static void put_u8(uint8_t v){
+	stage_buffer[stage_len++] = (char)v;
+}
+
+static void put_u16(uint16_t v){
+	put_u8((uint8_t)v);
+	put_u8((uint8_t)(v >> 8));
+}
+
+static void put_u32(uint32_t v){
+	put_u16((uint16_t)v);
+	put_u16((uint16_t)(v >> 16));
+}
+
+static void put_imu(void){
+	put_u16((uint16_t)imu.accel_x);
+	put_u16((uint16_t)imu.accel_y);
+	put_u16((uint16_t)imu.accel_z);
+	bbx_imu_x = imu.accel_x;
+	bbx_imu_y = imu.accel_y;
+	bbx_imu_z = imu.accel_z;
+	bbx_imu_valid = true;
+}
+
+static bool bbx_imu_changed(void){
+	return !bbx_imu_valid || (imu.accel_x != bbx_imu_x) || (imu.accel_y != bbx_imu_y) || (imu.accel_z != bbx_imu_z);
+}
+
+/* Delta to the previous record; a gap past u16 gets an absolute TIME record first */
+static uint16_t bbx_delta(uint32_t ts){
+	if ((int32_t)(ts - bbx_last_ts) < 0){
+		return 0; // LATE SAMPLE PAST THE REORDER WINDOW: PIN TO THE PREVIOUS RECORD, NEVER STEP BACK
+	}
+	uint32_t dt = ts - bbx_last_ts;
+	bbx_last_ts = ts;
+	if (dt > 0xFFFFU){
+		put_u8(BBX_REC_TIME);
+		put_u32(ts);
+		dt = 0;
+	}
+	return (uint16_t)dt;
+}
+
+static void stage_session_header(uint32_t start_ts){
+	put_u8(BBX_MAGIC0);
+	put_u8(BBX_MAGIC1);
+	put_u8(BBX_MAGIC2);
+	put_u8(BBX_MAGIC3);
+	put_u8(BBX_VERSION);
+	put_u8(BBX_HEADER_SIZE);
+	put_u16(0);
+	put_u32(TIMEBASE_HZ);
+	put_u32(start_ts);
+	bbx_last_ts = start_ts;
+	bbx_imu_valid = false;
+	bbx_sync_seq = timesync.seq - 1; // BUT REPEAT THE CURRENT UTC LABEL SO EVERY FILE IS SELF-CONTAINED
+}
+
+static void stage_can_frame(const can_frame_t *frame){
+	uint8_t dlc = (frame->dlc > 8) ? 8 : frame->dlc;
+	uint16_t dt = bbx_delta(frame->timestamp);
+	bool with_imu = !imu_streaming() && bbx_imu_changed();
+	put_u8(with_imu ? BBX_REC_CAN_IMU : BBX_REC_CAN);
+	put_u16(dt);
+	put_u16((uint16_t)frame->id);
+	put_u8(dlc);
+	for (int j = 0; j < dlc; j++){
+		put_u8(frame->data[j]);
+	}
+	if (with_imu){
+		put_imu();
+	}
+}
+
+static void stage_imu_row(uint32_t now){
+	uint16_t dt = bbx_delta(now);
+	put_u8(BBX_REC_IMU);
+	put_u16(dt);
+	put_imu();
+}
+
+static void stage_imu_sample(const imu_frame *sample){
+	uint16_t dt = bbx_delta(sample->timestamp);
+	put_u8(BBX_REC_IMU6);
+	put_u16(dt);
+	put_u16((uint16_t)sample->accel_x);
+	put_u16((uint16_t)sample->accel_y);
+	put_u16((uint16_t)sample->accel_z);
+	put_u16((uint16_t)sample->gyro_x);
+	put_u16((uint16_t)sample->gyro_y);
+	put_u16((uint16_t)sample->gyro_z);
+	put_u16((uint16_t)sample->temp);
+}
+
+static void stage_gps_fix(void){
+	uint16_t dt = bbx_delta(gps.timestamp);
+	put_u8(BBX_REC_GPS);
+	put_u16(dt);
+	put_u32((uint32_t)gps.lat_e7);
+	put_u32((uint32_t)gps.lon_e7);
+	put_u32((uint32_t)gps.alt_mm);
+	put_u32((uint32_t)gps.speed_mmps);
+	put_u16((uint16_t)gps.course_cdeg);
+	put_u8((uint8_t)((gps.fix_type & 0x0F) | (gps.locked ? 0x80 : 0)));
+	put_u8(gps.sats);
+}
+
+static void stage_dead_reckon(void){
+	uint16_t dt = bbx_delta(dead_reckon.timestamp);
+	put_u8(BBX_REC_DR);
+	put_u16(dt);
+	put_u32((uint32_t)dead_reckon.lat_e7);
+	put_u32((uint32_t)dead_reckon.lon_e7);
+	put_u16(dead_reckon.heading_cdeg);
+	put_u16((uint16_t)(dead_reckon.speed_mmps / 10));
+}
+
+/* Untimed like SKIP: the edge carries its own absolute timestamp */
+static void stage_time_sync(void){
+	if (!timesync.locked || (timesync.seq == bbx_sync_seq)){
+		return;
+	}
+	put_u8(BBX_REC_SYNC);
+	put_u32(timesync.pps_ts);
+	put_u32(timesync.date);
+	put_u32(timesync.utc_ms);
+	put_u32((uint32_t)timesync.drift_ppb);
+	bbx_sync_seq = timesync.seq;
+}
+
+#if PROF_ENABLE
+/* Untimed like SYNC; the probe is cleared so each record covers one interval */
+static void stage_prof(prof_id_t id, uint32_t now){
+	prof_stats_t s;
+	prof_snapshot(id, &s, true);
+	if (s.count == 0){
+		return;
+	}
+	const char *name = prof_name(id);
+	uint8_t name_len = 0;
+	while ((name_len < PROF_NAME_MAX) && (name[name_len] != '\0')){
+		name_len++;
+	}
+	uint8_t first = 0;
+	uint8_t last = PROF_BINS - 1;
+	while (s.hist[first] == 0){
+		first++; // count > 0, SO SOME BIN IS SET
+	}
+	while (s.hist[last] == 0){
+		last--;
+	}
+
+	put_u8(BBX_REC_PROF);
+	put_u32(now);
+	put_u32(SystemCoreClock);
+	put_u8(name_len);
+	for (uint8_t i = 0; i < name_len; i++){
+		put_u8((uint8_t)name[i]);
+	}
+	put_u32(s.count);
+	put_u32(s.min);
+	put_u32(s.max);
+	put_u32((uint32_t)(s.sum / s.count));
+	put_u8(first);
+	put_u8((uint8_t)(last - first + 1));
+	for (uint8_t b = first; b <= last; b++){
+		put_u32(s.hist[b]);
+	}
+}
+#endif
+
+/* Untimed: every field is from the previous run */
+static void stage_crash(reset_cause_t cause, const crash_record_t *rec){
+	put_u8(BBX_REC_CRASH);
+	put_u8((uint8_t)cause);
+	put_u8(rec->kind);
+	put_u8(rec->held);
+	put_u8(rec->state);
+	put_u8(rec->task);
+	put_u32(rec->uptime_ms);
+	for (int i = 0; i < 8; i++){
+		put_u32(rec->r[i]);
+	}
+	put_u32(rec->exc_return);
+	put_u32(rec->sp);
+	put_u32(rec->cfsr);
+	put_u32(rec->hfsr);
+	put_u32(rec->mmfar);
+	put_u32(rec->bfar);
+	put_u32(rec->can_head);
+	put_u32(rec->can_tail);
+	put_u32(rec->can_dropped);
+	put_u32(rec->prio_head);
+	put_u32(rec->prio_tail);
+	put_u32(rec->prio_dropped);
+	put_u32(rec->staged);
+}
+
+static void stage_skip_count(uint16_t id, uint16_t skipped){
+	put_u8(BBX_REC_SKIP);
+	put_u16(id);
+	put_u16(skipped);
+}
+#else
+static void stage_session_header(uint32_t start_ts){
+	(void)start_ts; // CSV FILES CARRY NO HEADER ROW
+}
+
+static void stage_can_frame(const can_frame_t *frame){
+	uint8_t padded_data[8];
+	for (int j = 0; j < 8; j++){
+		if (j >= frame->dlc){
+			padded_data[j] = 0;
+		}
+		else if (j < frame->dlc){
+			padded_data[j] = frame->data[j];
+		}
+	}
+	int written = snprintf(stage_buffer + stage_len, SD_STAGE_SIZE - stage_len, "%lu,0x%03lX,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", frame->timestamp, frame->id, frame->dlc, padded_data[0], padded_data[1], padded_data[2], padded_data[3],
+	        padded_data[4], padded_data[5], padded_data[6], padded_data[7], imu.accel_x, imu.accel_y, imu.accel_z);
+	stage_len += written;
+}
+
+static void stage_imu_row(uint32_t now){
+	int imu_written = snprintf(stage_buffer + stage_len, SD_STAGE_SIZE - stage_len, "%lu,0x%03lX,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", now, 0xFFFFUL, 0, 0, 0, 0, 0, 0, 0, 0, 0, imu.accel_x, imu.accel_y, imu.accel_z);
+	stage_len += imu_written;
+}
+
+static void stage_imu_sample(const imu_frame *sample){
+	stage_imu_row(sample->timestamp); // CSV KEEPS ITS ACCEL-ONLY COLUMNS, imu HOLDS THIS SAMPLE
+}
+
+static void stage_gps_fix(void){
+	// CSV ROWS HAVE NO GPS COLUMNS
+}
+
+static void stage_dead_reckon(void){
+}
+
+static void stage_time_sync(void){
+}
+
+#if PROF_ENABLE
+static void stage_prof(prof_id_t id, uint32_t now){
+	(void)id; // CSV ROWS HAVE NO PROFILING COLUMNS; THE DEBUG UART DUMP STILL WORKS
+	(void)now;
+}
+#endif
+
+static void stage_crash(reset_cause_t cause, const crash_record_t *rec){
+	(void)cause; // CSV ROWS HAVE NO CRASH COLUMNS; THE CRASH_BOOT TRACE STILL REPORTS IT
+	(void)rec;
+}
+
+static void stage_skip_count(uint16_t id, uint16_t skipped){
+	(void)id; // CSV ROWS HAVE NO COLUMN FOR SUPPRESSED COUNTS
+	(void)skipped;
+}
+#endif
+
+/* Write every pending suppressed count so per-ID rates survive decimation */
+static void stage_skip_summary(void){
+	uint32_t cursor = 0;
+	uint16_t id, skipped;
+	while ((SD_STAGE_SIZE - stage_len) >= SD_ROW_MAX && log_policy_next_skipped(&cursor, &id, &skipped)){
+		stage_skip_count(id, skipped);
+	}
+	last_skip_summary_time = HAL_GetTick();
+}
+
+/* Periodic hot-path timings, so deadline misses can be matched to bus load in the same log */
+static void stage_prof_summary(void){
+#if PROF_ENABLE
+	uint32_t now = timebase_now_us();
+	for (int i = 0; i < PROF_COUNT; i++){
+		if ((SD_STAGE_SIZE - stage_len) < SD_PROF_ROW_MAX){
+			break; // LEFT FOR THE NEXT INTERVAL
+		}
+		stage_prof((prof_id_t)i, now);
+	}
+#endif
+	last_prof_time = HAL_GetTick();
+}
+
+/*
+ * Advance the card busy poll; write staged rows once the card has finished
+ * programming. Its own task (task_sd), so the drain in task_can never waits
+ * on the card.
+ */
+void SD_Logger_Service(void){
+	if (fault_flags.sd_fault){
+		return; // NO MORE WRITES TO A FAILED CARD; SYS_LOGGING ABORTS THE SESSION ON ITS NEXT TICK
+	}
+	sd_io_state_t io = SD_IO_Poll();
+	if (io == SD_IO_ERROR){
+		fault_flags.sd_fault = true;
+		return;
+	}
+	if (io == SD_IO_BUSY){
+		return; // KEEP BUFFERING
+	}
+	if ((stage_len > 0) && ((HAL_GetTick() - last_flush_time) >= SD_FLUSH_AGE_MS)){
+		stage_flush(true);
+	}
+	else if (stage_len >= SD_FLUSH_BYTES){
+		stage_flush(false);
+	}
+}
 
 bool SD_Logger_Init(void) {
 	/* Immediate mount (opt = 1) also runs USER_initialize through FatFs */
 	FRESULT res = f_mount(&fs, USERPath, 1);
+	imu_filter_init();
+	dead_reckon_reset();
 	sd_mount = (res == FR_OK);
 	if (res != FR_OK){
 		fault_flags.sd_fault = true;
@@ -37,7 +448,7 @@ bool SD_Logger_Init(void) {
 void start_new_session_file(void){
 	static int session_number = 0;
 	/* Session number is reset on MCU restart; replace with GPS/RTC naming later */
-	snprintf(filename, sizeof(filename), "log_%03d.csv", session_number);
+	snprintf(filename, sizeof(filename), "log_%03d" SD_LOG_EXT, session_number);
 	session_number++;
 
 	FRESULT res = f_open(&log_file, filename, FA_CREATE_ALWAYS | FA_WRITE);
@@ -45,12 +456,58 @@ void start_new_session_file(void){
 	if (res != FR_OK){
 		fault_flags.sd_fault = true;
 	}
+	TRACE(SESSION_OPEN, session_number - 1, fault_flags.sd_fault);
+	stage_len = 0;
+	stage_session_header(timebase_now_us());
+	const crash_record_t *crash;
+	if ((res == FR_OK) && crash_pending(&crash)){
+		stage_crash(crash_reset_cause(), crash); // FIRST SESSION AFTER AN ABNORMAL RESET, BEFORE ANY FRAME
+		crash_logged();
+	}
+	merged_gps_seq = gps.seq; // FIRST GPS RECORD IS THE NEXT FIX, NOT A STALE ONE
+	log_policy_reset();
+	imu_filter_reset();
+	last_skip_summary_time = HAL_GetTick();
+	prof_reset(); // FIRST PROF RECORDS COVER THIS SESSION ONLY
+	last_prof_time = HAL_GetTick();
+}
+
+uint32_t SD_Logger_Staged(void){
+	return (uint32_t)stage_len;
+}
+
+uint32_t SD_Logger_Dropped(void){
+	return stage_dropped_bytes;
+}
+
+/* Every session end reports what never reached the stage, so losses show without a debugger */
+static void trace_can_loss(void){
+	TRACE(CAN_LOSS, can_hw_stats.fifo0_overrun, can_hw_stats.fifo0_full, can_hw_stats.fifo1_overrun,
+	      can_hw_stats.fifo1_full, can_rb.dropped_count, can_rb_priority.dropped_count);
 }
 
 void close_session_file(void){
 	/* Commit cached data before closing so removal/power-down does not lose it */
+	stage_skip_summary();
+	stage_flush_all(); // BLOCKING: FatFs waits out any pending card busy
 	f_sync(&log_file);
 	f_close(&log_file);
+	TRACE(SESSION_CLOSE);
+	trace_can_loss();
+}
+
+/*
+ * A write failed or the card's busy timed out: the staged rows are dropped and
+ * the file gets one close attempt, bounded by the driver timeouts, so whatever
+ * already reached a card that answers again stays readable. sd_mount goes false
+ * so SYS_FAULT remounts before the next session.
+ */
+void abort_session_file(void){
+	stage_drop();
+	f_close(&log_file);
+	sd_mount = false;
+	TRACE(SESSION_ABORT, stage_dropped_bytes);
+	trace_can_loss();
 }
 
 void sd_recovery(void) {
@@ -72,57 +529,111 @@ void unmount_sd(void){
 	sd_mount = false;
 }
 
+/* Merge FIFO0 and FIFO1 rings oldest-first so the record stream stays in time order */
+static can_ring_buffer_t *next_ring(void){
+	const can_frame_t *bulk = CANRingBuffer_Peek(&can_rb);
+	const can_frame_t *priority = CANRingBuffer_Peek(&can_rb_priority);
+	if (priority == NULL){
+		return (bulk != NULL) ? &can_rb : NULL;
+	}
+	if (bulk == NULL){
+		return &can_rb_priority;
+	}
+	return ((int32_t)(priority->timestamp - bulk->timestamp) <= 0) ? &can_rb_priority : &can_rb;
+}
+
+/* A CAN frame newer than the last filtered IMU time waits until the burst covering it lands */
+static bool can_waits_for_imu(const can_frame_t *frame){
+	if (!imu_streaming() || ((int32_t)(frame->timestamp - (imu_horizon() - IMU_FILTER_DELAY_US)) <= 0)){
+		return false;
+	}
+	return (timebase_now_us() - frame->timestamp) < SD_IMU_REORDER_US;
+}
+
 void SD_Logger_DrainCAN(void){
-	can_frame_t frame;
-	int offset = 0;
-	UINT bytes_written = 0; // total bytes written
-	char csv_buffer[1024];  // batch several CAN frames into one FatFs write
+	PROF_START(SD_DRAIN);
 
 	/* Limit work per FSM tick so logging does not block the rest of the system */
-	for (int i = 0; i < 16; i++){
-		bool got_frame = CANRingBuffer_Pop(&can_rb, &frame);
-		if(!got_frame){
-			break;
+	for (int i = 0; i < 32; i++){
+		if ((SD_STAGE_SIZE - stage_len) < SD_ROW_MAX){
+			break; // STAGE FULL WHILE CARD IS BUSY: FRAMES WAIT IN can_rb
 		}
+		can_ring_buffer_t *rb = next_ring();
+		const can_frame_t *frame = (rb != NULL) ? CANRingBuffer_Peek(rb) : NULL;
+		const imu_frame *sample = imu_ring_peek();
 
-		uint8_t padded_data[8];
-		for (int j = 0; j < 8; j++){
-			if (j >= frame.dlc){
-				padded_data[j] = 0;
-			}
-			else if (j < frame.dlc){
-				padded_data[j] = frame.data[j];
+		/* A fix is staged once it is the oldest thing waiting, like the other two sources */
+		if ((gps.seq != merged_gps_seq) &&
+		    ((frame == NULL) || ((int32_t)(gps.timestamp - frame->timestamp) <= 0)) &&
+		    ((sample == NULL) || ((int32_t)(gps.timestamp - (sample->timestamp - IMU_FILTER_DELAY_US)) <= 0))){
+			dead_reckon_fix();
+			stage_gps_fix();
+			merged_gps_seq = gps.seq;
+			continue;
+		}
+
+		/* Compare on the filter's output time: raw timestamp minus its group delay */
+		if ((sample != NULL) && ((frame == NULL) || ((int32_t)(sample->timestamp - IMU_FILTER_DELAY_US - frame->timestamp) <= 0))){
+			imu_frame filtered;
+			imu_cal_observe(sample);
+			if (imu_filter_push(sample, &filtered)){
+				imu = filtered; // CURRENT SAMPLE FOR THE CSV COLUMNS AND THE DEBUG PRINT
+				stage_imu_sample(&filtered);
+				dead_reckon_step(&filtered);
+				if (dead_reckon_emit()){
+					stage_dead_reckon();
+				}
+				last_row_write_time = HAL_GetTick();
 			}
+			imu_ring_release();
+			continue;
+		}
+		if ((frame == NULL) || can_waits_for_imu(frame)){
+			break;
 		}
-		int written = snprintf(csv_buffer + offset, sizeof(csv_buffer) - offset, "%lu,0x%03lX,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", frame.timestamp, frame.id, frame.dlc, padded_data[0], padded_data[1], padded_data[2], padded_data[3],
-		        padded_data[4], padded_data[5], padded_data[6], padded_data[7], imu.accel_x, imu.accel_y, imu.accel_z);
-		offset += written;
-		last_row_write_time = HAL_GetTick();
-	}
 
-	if (offset == 0){ // TIMEOUT FEATURE FOR EMPTY CAN ROWS WITH IMU DATA
-		if ((HAL_GetTick() - last_row_write_time) >= 200){
-			int imu_written = snprintf(csv_buffer + offset, sizeof(csv_buffer) - offset, "%lu,0x%03lX,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", HAL_GetTick(), 0xFFFFUL, 0, 0, 0, 0, 0, 0, 0, 0, 0, imu.accel_x, imu.accel_y, imu.accel_z);
-			offset += imu_written;
+		can_decode_frame(frame); // EVERY FRAME, EVEN ONES THE POLICY DROPS
+		uint16_t skipped;
+		if (log_policy_admit(frame, &skipped)){
+			if (skipped != 0){
+				stage_skip_count((uint16_t)frame->id, skipped);
+			}
+			stage_can_frame(frame); // FORMAT STRAIGHT FROM THE SLOT, NO COPY
 			last_row_write_time = HAL_GetTick();
 		}
+		CANRingBuffer_Release(rb);
+	}
+
+	if ((SD_STAGE_SIZE - stage_len) >= SD_ROW_MAX){
+		stage_time_sync();
+	}
+
+	if ((HAL_GetTick() - last_skip_summary_time) >= LOG_POLICY_SUMMARY_MS){
+		stage_skip_summary();
 	}
 
-	if (offset > 0){
-		FRESULT verify = f_write(&log_file, csv_buffer, offset, &bytes_written);
-		if (verify != FR_OK){
-			fault_flags.sd_fault = true;
+	if ((HAL_GetTick() - last_prof_time) >= SD_PROF_PERIOD_MS){
+		stage_prof_summary();
+	}
+
+	if (!imu_streaming() && ((HAL_GetTick() - last_row_write_time) >= 200)){ // TIMEOUT FEATURE FOR EMPTY CAN ROWS WITH IMU DATA
+		if ((SD_STAGE_SIZE - stage_len) >= SD_ROW_MAX){
+			stage_imu_row(timebase_now_us());
+			last_row_write_time = HAL_GetTick();
 		}
 	}
+
+	PROF_STOP(SD_DRAIN);
 }
 
 void flush_ring_buffers(void){
 	int drain_count = 0;
-	while (can_rb.count > 0){
+	while ((CANRingBuffer_Count(&can_rb) + CANRingBuffer_Count(&can_rb_priority)) > 0){
 		if (drain_count>= 1000){
 			break;
 		}
 		SD_Logger_DrainCAN();
+		SD_Logger_Service(); // A FULL STAGE WOULD STALL THE DRAIN
 		drain_count++;
 	}
 }
@@ -0,0 +1,112 @@
+/*
+ * tasks.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// APPLICATION TASK TABLE: PERIODS, DEADLINES AND BUDGETS FOR THE SCHEDULER
+
+#include "tasks.h"
+#include "main.h"
+#include "iwdg.h"
+#include "usart.h"
+#include "can_handler.h"
+#include "sd_logger.h"
+#include "fsm_sys.h"
+#include "imu.h"
+#include "gps_driver.h"
+#include "timesync.h"
+#include "fault.h"
+#include "prof.h"
+#include "trace.h"
+#include "clock_profile.h"
+#include "lowpower.h"
+#include "crash.h"
+#include <string.h>
+
+uint32_t health_missed_refresh = 0;
+
+/* Drains the CAN and IMU rings to the SD stage; formatting only, the card is written by task_sd */
+static void task_can(void){
+	CAN_Handler_RecoverBusOff();
+	if (current_state == SYS_LOGGING){
+		SD_Logger_DrainCAN();
+	}
+}
+
+/* While logging the drain owns the IMU ring; otherwise keep imu current for the monitor */
+static void task_imu(void){
+	if (current_state == SYS_IDLE){
+		imu_read();
+	}
+}
+
+/* 2 KB DMA ring holds ~170 ms at 115200 */
+static void task_gps(void){
+	GPS_Driver_Update();
+	timesync_update();
+}
+
+/* The clock follows the state the FSM has just settled in; in SYS_IDLE the board then sleeps here */
+static void task_logger(void){
+	SYS_FSM_TICK();
+	clock_profile_update(current_state);
+	lowpower_update(current_state);
+}
+
+/* Hands staged rows to FatFs once the card is idle, one SD_FLUSH_BYTES burst at most per run */
+static void task_sd(void){
+	if (current_state == SYS_LOGGING){
+		SD_Logger_Service();
+	}
+}
+
+/* Debug UART commands: "prof" dumps probe and task timings and CAN losses, "prof reset" starts a new interval, "clock" the profile residency, "power" STOP-mode wakes and latency */
+static void console_command(const char *cmd){
+	if (strcmp(cmd, "prof") == 0){
+		prof_dump();
+		can_handler_dump();
+	}
+	else if (strcmp(cmd, "prof reset") == 0){
+		prof_reset();
+		DBG_Print("prof: cleared\r\n");
+	}
+	else if (strcmp(cmd, "clock") == 0){
+		clock_profile_dump();
+	}
+	else if (strcmp(cmd, "power") == 0){
+		lowpower_dump();
+	}
+	else{
+		DBG_Print("commands: prof, prof reset, clock, power\r\n");
+	}
+}
+
+/* TEMP: USART2 IMU monitor at 5 Hz. Remove with MX_USART2_UART_Init when done. */
+static void task_ui(void){
+	char cmd[DBG_LINE_MAX];
+	if (DBG_ReadLine(cmd, sizeof(cmd))){
+		console_command(cmd);
+	}
+	TRACE(IMU_MONITOR, imu.timestamp, imu.accel_x, imu.accel_y, imu.accel_z,
+	      fault_flags.imu_fault, fault_flags.imu_handshake_fault);
+}
+
+/* A task that hangs or starves stops the refresh; the IWDG (~8 s) then resets the board */
+static void task_health(void){
+	crash_checkpoint(); // WHAT THE NEXT BOOT LOGS IF THAT RESET COMES
+	if (scheduler_check_in_all()){
+		HAL_IWDG_Refresh(&hiwdg);
+	}
+	else{
+		health_missed_refresh++;
+		TRACE(HEALTH_WITHHELD, health_missed_refresh);
+	}
+}
+
+const sched_task_t app_tasks[TASK_COUNT] = {
+#define TASK_ENTRY(id, name, body, period, offset, deadline, budget) [TASK_##id] = {name, body, period, offset, deadline, budget},
+	APP_TASKS(TASK_ENTRY)
+#undef TASK_ENTRY
+};
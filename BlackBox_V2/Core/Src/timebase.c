@@ -0,0 +1,79 @@
+/*
+ * timebase.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+#include "timebase.h"
+
+volatile uint32_t timebase_pps_ts = 0;
+volatile uint32_t timebase_pps_count = 0;
+
+/* TIM2 sits on APB1; its kernel clock is doubled whenever APB1 is divided */
+static uint32_t timebase_tim2_clock(void){
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	if ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_CFGR_PPRE1_DIV1){
+		return pclk1;
+	}
+	return pclk1 * 2U;
+}
+
+void timebase_init(void){
+	__HAL_RCC_TIM2_CLK_ENABLE();
+
+	TIM2->CR1 = 0;
+	TIM2->PSC = (timebase_tim2_clock() / TIMEBASE_HZ) - 1U;
+	TIM2->ARR = 0xFFFFFFFFU;
+	TIM2->CNT = 0;
+	TIM2->EGR = TIM_EGR_UG; // LATCH PSC NOW, NOT AT THE FIRST OVERFLOW
+	TIM2->SR = 0;
+	TIM2->CR1 = TIM_CR1_CEN;
+}
+
+/*
+ * After an APB1 prescaler change. UG latches the new PSC but also zeroes CNT,
+ * so the count is carried over by hand; call with interrupts masked.
+ */
+void timebase_clock_update(void){
+	uint32_t psc = (timebase_tim2_clock() / TIMEBASE_HZ) - 1U;
+	if (TIM2->PSC == psc){
+		return;
+	}
+	uint32_t cnt = TIM2->CNT;
+	TIM2->PSC = psc;
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->CNT = cnt;
+	TIM2->SR = (uint32_t)~TIM_SR_UIF;
+}
+
+void timebase_pps_init(void){
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	GPIO_InitStruct.Pin = PPS_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_PULLDOWN; // NO PULSES UNTIL THE RECEIVER HAS A FIX
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	GPIO_InitStruct.Alternate = GPIO_AF1_TIM2;
+	HAL_GPIO_Init(PPS_GPIO_Port, &GPIO_InitStruct);
+
+	/* CC1 input on TI1, rising edge, no prescaler, 8-sample filter at the timer clock */
+	TIM2->CCER &= ~(TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP);
+	TIM2->CCMR1 = (TIM2->CCMR1 & ~(TIM_CCMR1_CC1S | TIM_CCMR1_IC1PSC | TIM_CCMR1_IC1F)) |
+	              TIM_CCMR1_CC1S_0 | (0x3U << TIM_CCMR1_IC1F_Pos);
+	TIM2->SR = (uint32_t)~(TIM_SR_CC1IF | TIM_SR_CC1OF);
+	TIM2->CCER |= TIM_CCER_CC1E;
+	TIM2->DIER |= TIM_DIER_CC1IE;
+
+	HAL_NVIC_SetPriority(TIM2_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+void timebase_pps_isr(void){
+	if (TIM2->SR & TIM_SR_CC1IF){
+		timebase_pps_ts = TIM2->CCR1; // READING CCR1 CLEARS CC1IF
+		timebase_pps_count++;
+	}
+	TIM2->SR = (uint32_t)~TIM_SR_CC1OF; // A MISSED EDGE SHOWS UP AS A TWO-SECOND INTERVAL
+}
@@ -0,0 +1,130 @@
+/*
+ * timesync.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// GPS PPS DISCIPLINE: LABEL CAPTURED EDGES WITH UTC AND TRACK TIMEBASE DRIFT
+
+#include "timesync.h"
+#include "timebase.h"
+#include "gps_driver.h"
+#include <string.h>
+
+#define US_PER_S   1000000L
+#define MS_PER_DAY 86400000UL
+
+timesync_t timesync;
+
+static uint32_t ts_pps_count = 0;	// timebase_pps_count ALREADY SEEN
+static uint32_t ts_time_seq = 0;	// gps_time.seq ALREADY SEEN
+static uint32_t ts_edge = 0;		// NEWEST EDGE, LABELLED OR NOT
+static bool ts_edge_valid = false;
+static bool ts_drift_valid = false;
+
+void timesync_init(void){
+	memset(&timesync, 0, sizeof(timesync));
+	ts_pps_count = 0;
+	ts_time_seq = gps_time.seq;
+	ts_edge_valid = false;
+	ts_drift_valid = false;
+	timebase_pps_init();
+}
+
+/* Consistent (count, timestamp) pair against the capture interrupt */
+static uint32_t pps_snapshot(uint32_t *ts){
+	uint32_t count;
+	do {
+		count = timebase_pps_count;
+		*ts = timebase_pps_ts;
+	} while (count != timebase_pps_count);
+	return count;
+}
+
+static void label_edge(uint32_t edge, uint32_t utc_ms, uint32_t date){
+	timesync.pps_ts = edge;
+	timesync.utc_ms = utc_ms;
+	timesync.date = date;
+	timesync.locked = true;
+	timesync.seq++;
+}
+
+/* A new edge: carry the label forward by whole seconds and update the drift estimate */
+static void on_edge(uint32_t edge){
+	ts_edge = edge;
+	ts_edge_valid = true;
+	if (!timesync.locked){
+		return;
+	}
+
+	uint32_t d = edge - timesync.pps_ts;
+	int32_t n = (int32_t)((d + US_PER_S / 2) / US_PER_S);
+	int32_t err = (int32_t)(d - (uint32_t)n * US_PER_S);
+	if ((n < 1) || (n > TIMESYNC_MAX_GAP_S) || (err > TIMESYNC_TOL_US * n) || (err < -TIMESYNC_TOL_US * n)){
+		timesync.rejects++;
+		timesync.locked = false; // SPURIOUS OR LONG-LOST PULSES: WAIT FOR THE NEXT TIME MESSAGE
+		return;
+	}
+
+	int32_t sample = (int32_t)(((int64_t)err * 1000) / n); // US PER S = PPM, x1000 = PPB
+	if (!ts_drift_valid){
+		timesync.drift_ppb = sample;
+		ts_drift_valid = true;
+	}
+	else{
+		timesync.drift_ppb += (sample - timesync.drift_ppb) / (1 << TIMESYNC_DRIFT_SHIFT);
+	}
+
+	uint32_t utc_ms = timesync.utc_ms + (uint32_t)n * 1000UL;
+	uint32_t date = timesync.date;
+	if (utc_ms >= MS_PER_DAY){
+		utc_ms -= MS_PER_DAY;
+		date = 0; // DDMMYY CANNOT BE STEPPED HERE; THE NEXT TIME MESSAGE FILLS IT IN
+	}
+	label_edge(edge, utc_ms, date);
+}
+
+/*
+ * A time message describes an epoch at or after the newest edge and its burst
+ * starts well under half a second later, so stepping back by the burst's age
+ * and rounding to the second names the edge.
+ */
+static void on_time(void){
+	uint32_t since = gps_time.timestamp - ts_edge;
+	if (!ts_edge_valid || (since >= (uint32_t)US_PER_S) || (gps_time.utc_ms >= MS_PER_DAY)){
+		return; // NO EDGE YET, OR THE MESSAGE BELONGS TO AN EARLIER SECOND
+	}
+
+	int32_t est = (int32_t)gps_time.utc_ms - (int32_t)(since / 1000);
+	int32_t utc_s = (est + 500) / 1000;
+	if (est < -500){
+		return; // EDGE FELL ON THE PREVIOUS DAY; LABEL THE NEXT ONE INSTEAD
+	}
+	uint32_t utc_ms = ((uint32_t)utc_s * 1000UL) % MS_PER_DAY;
+
+	if (timesync.locked && (timesync.pps_ts == ts_edge)){
+		if (timesync.utc_ms != utc_ms){
+			timesync.relabels++;
+			label_edge(ts_edge, utc_ms, gps_time.date);
+		}
+		else if (timesync.date != gps_time.date){
+			timesync.date = gps_time.date;
+		}
+		return;
+	}
+	label_edge(ts_edge, utc_ms, gps_time.date);
+}
+
+void timesync_update(void){
+	uint32_t edge;
+	uint32_t count = pps_snapshot(&edge);
+	if (count != ts_pps_count){
+		ts_pps_count = count; // EDGES OVERWRITTEN BEFORE THIS RUN SHOW UP AS A MULTI-SECOND STEP
+		on_edge(edge);
+	}
+	if (gps_time.seq != ts_time_seq){
+		ts_time_seq = gps_time.seq;
+		on_time();
+	}
+}
@@ -0,0 +1,132 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// DEFERRED TRACE: ID + RAW ARGS INTO A RAM RING, DRAINED BY USART2 TX DMA
+
+#include "trace.h"
+#include "main.h"
+#include "usart.h"
+#include "timebase.h"
+#include <string.h>
+
+#define TRACE_RING_SIZE 4096	// POWER OF TWO; ~350 MS OF LINE TIME AT 115200
+#define TRACE_OVERHEAD  8		// SYNC, ID, LENGTH, TIMESTAMP x4, SUM
+
+static uint8_t trace_ring[TRACE_RING_SIZE];
+static uint32_t trace_head = 0;	// FREE-RUNNING BYTE COUNTS, MASKED ON ACCESS
+static uint32_t trace_tail = 0;
+static uint32_t trace_inflight = 0;	// BYTES HANDED TO THE DMA, RELEASED ON COMPLETION
+static uint32_t trace_dropped_unreported = 0;
+volatile uint32_t trace_dropped = 0;
+
+static void trace_dma_done(DMA_HandleTypeDef *hdma);
+
+/* After MX_USART2_UART_Init; the stream feeds USART2->DR directly, outside the HAL UART state machine */
+void trace_init(void){
+	trace_head = 0;
+	trace_tail = 0;
+	trace_inflight = 0;
+	trace_dropped_unreported = 0;
+	trace_dropped = 0;
+	hdma_usart2_tx.XferCpltCallback = trace_dma_done;
+	hdma_usart2_tx.XferErrorCallback = trace_dma_done; // A FAILED RUN IS SKIPPED; THE HOST RESYNCS ON THE NEXT ENTRY
+	SET_BIT(USART2->CR3, USART_CR3_DMAT);
+}
+
+static uint8_t ring_put(uint8_t c){
+	trace_ring[trace_head & (TRACE_RING_SIZE - 1)] = c;
+	trace_head++;
+	return c;
+}
+
+static void ring_entry(uint8_t id, const uint8_t *payload, uint8_t len){
+	uint32_t ts = timebase_now_us();
+	uint8_t sum = 0;
+	ring_put(TRACE_SYNC);
+	sum += ring_put(id);
+	sum += ring_put(len);
+	for (int i = 0; i < 4; i++){
+		sum += ring_put((uint8_t)(ts >> (8 * i)));
+	}
+	for (uint8_t i = 0; i < len; i++){
+		sum += ring_put(payload[i]);
+	}
+	ring_put(sum);
+}
+
+/* Next contiguous run to the DMA; caller holds interrupts off */
+static void trace_kick(void){
+	if ((trace_inflight != 0) || (trace_head == trace_tail)){
+		return;
+	}
+	uint32_t start = trace_tail & (TRACE_RING_SIZE - 1);
+	uint32_t len = trace_head - trace_tail;
+	if (len > (TRACE_RING_SIZE - start)){
+		len = TRACE_RING_SIZE - start; // WRAP: THE REST GOES ON THE NEXT COMPLETION
+	}
+	if (HAL_DMA_Start_IT(&hdma_usart2_tx, (uint32_t)(uintptr_t)&trace_ring[start], (uint32_t)(uintptr_t)&USART2->DR, len) == HAL_OK){
+		trace_inflight = len;
+	}
+}
+
+/* Whole entries or nothing; a full ring drops the entry and reports the loss in a later one */
+static bool trace_put(uint8_t id, const uint8_t *payload, uint8_t len){
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t space = TRACE_RING_SIZE - (trace_head - trace_tail);
+	bool ok = false;
+
+	if ((trace_dropped_unreported != 0) && (space >= (2U * TRACE_OVERHEAD + 4U + len))){
+		uint8_t lost[4];
+		memcpy(lost, &trace_dropped_unreported, sizeof(lost));
+		ring_entry(TRACE_ID_TRACE_DROPPED, lost, sizeof(lost));
+		space -= TRACE_OVERHEAD + sizeof(lost);
+		trace_dropped_unreported = 0;
+	}
+	if ((trace_dropped_unreported == 0) && (space >= (TRACE_OVERHEAD + (uint32_t)len))){
+		ring_entry(id, payload, len);
+		ok = true;
+	}
+	else{
+		trace_dropped_unreported++;
+		trace_dropped++;
+	}
+	trace_kick();
+	__set_PRIMASK(primask);
+	return ok;
+}
+
+bool trace_write(trace_id_t id, const uint32_t *args, uint32_t count){
+	if (count > TRACE_MAX_ARGS){
+		count = TRACE_MAX_ARGS;
+	}
+	return trace_put((uint8_t)id, (const uint8_t *)args, (uint8_t)(count * 4)); // CORTEX-M IS LITTLE-ENDIAN, AS ON THE WIRE
+}
+
+bool trace_text(const char *s){
+	size_t len = strlen(s);
+	if (len > TRACE_TEXT_MAX){
+		len = TRACE_TEXT_MAX;
+	}
+	return trace_put(TRACE_ID_TEXT, (const uint8_t *)s, (uint8_t)len);
+}
+
+/* Ring empty and the last byte off the wire: the UART can lose its clock without garbling an entry */
+bool trace_idle(void){
+	return (trace_head == trace_tail) && (trace_inflight == 0) && ((USART2->SR & USART_SR_TC) != 0);
+}
+
+/* DMA1 Stream6 transfer complete (or error), in its interrupt */
+static void trace_dma_done(DMA_HandleTypeDef *hdma){
+	(void)hdma;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	trace_tail += trace_inflight;
+	trace_inflight = 0;
+	trace_kick();
+	__set_PRIMASK(primask);
+}
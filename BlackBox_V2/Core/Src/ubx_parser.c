@@ -0,0 +1,284 @@
+/*
+ * ubx_parser.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// U-BLOX UBX BINARY PROTOCOL: BYTE-AT-A-TIME FRAMING, FLETCHER CHECKSUM, NAV DECODE
+
+#include "ubx_parser.h"
+#include <string.h>
+
+enum {
+	UBX_ST_SYNC1,
+	UBX_ST_SYNC2,
+	UBX_ST_CLASS,
+	UBX_ST_ID,
+	UBX_ST_LEN1,
+	UBX_ST_LEN2,
+	UBX_ST_PAYLOAD,
+	UBX_ST_CK_A,
+	UBX_ST_CK_B
+};
+
+void ubx_init(ubx_parser_t *p){
+	memset(p, 0, sizeof(*p));
+	p->state = UBX_ST_SYNC1;
+}
+
+/* UBX is little-endian on the wire */
+static uint16_t rd_u16(const uint8_t *b){
+	return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+static uint32_t rd_u32(const uint8_t *b){
+	return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static int32_t rd_i32(const uint8_t *b){
+	return (int32_t)rd_u32(b);
+}
+
+/* 1e-5 DEG -> 0.01 DEG, rounded */
+static int32_t heading_cdeg(int32_t h){
+	return (h >= 0) ? ((h + 500) / 1000) : ((h - 500) / 1000);
+}
+
+/* UTC fields shared by NAV-TIMEUTC and NAV-PVT; nano may be negative */
+static void set_utc(gps_fix_t *fix, uint16_t year, uint8_t month, uint8_t day,
+		uint8_t hh, uint8_t mm, uint8_t ss, int32_t nano){
+	int32_t ms = (int32_t)(((hh * 60UL + mm) * 60UL + ss) * 1000UL) + nano / 1000000;
+	if (ms < 0){
+		ms = 0; // DAY ROLLOVER EDGE, KEEP THE PREVIOUS DATE ABOVE CONSISTENT
+	}
+	fix->time_ms = (uint32_t)ms;
+	fix->date = (uint32_t)day * 10000UL + (uint32_t)month * 100UL + (uint32_t)(year % 100);
+}
+
+/* Release staged position/velocity once the SOL for their epoch is known */
+static uint8_t epoch_commit(ubx_parser_t *p, gps_fix_t *fix){
+	uint8_t done = 0;
+	if (!p->sol_seen){
+		return 0;
+	}
+	if (p->pos_pending && (p->pos_itow == p->sol_itow)){
+		p->pos_pending = false;
+		if (p->sol_ok){
+			fix->lat_e7 = p->pos_lat_e7;
+			fix->lon_e7 = p->pos_lon_e7;
+			fix->alt_mm = p->pos_alt_mm;
+			done |= UBX_POS;
+		}
+	}
+	if (p->vel_pending && (p->vel_itow == p->sol_itow)){
+		p->vel_pending = false;
+		if (p->sol_ok){
+			fix->speed_mmps = p->vel_speed_mmps;
+			fix->course_cdeg = p->vel_course_cdeg;
+			done |= UBX_VEL;
+		}
+	}
+	return done;
+}
+
+/* NAV-SOL gpsFix: 0 NONE, 1 DR, 2 2D, 3 3D, 4 GPS+DR, 5 TIME ONLY -> GSA 1/2/3 */
+static uint8_t fix_type_gsa(uint8_t gps_fix){
+	if (gps_fix == 2) return 2;
+	if ((gps_fix == 3) || (gps_fix == 4)) return 3;
+	return 1;
+}
+
+static uint8_t nav_message(ubx_parser_t *p, gps_fix_t *fix){
+	const uint8_t *b = p->payload;
+
+	switch (p->id){
+	case UBX_NAV_POSLLH:
+		if (p->length != 28) break;
+		p->pos_itow = rd_u32(&b[0]);
+		p->pos_lon_e7 = rd_i32(&b[4]);
+		p->pos_lat_e7 = rd_i32(&b[8]);
+		p->pos_alt_mm = rd_i32(&b[16]); // hMSL, SAME DATUM AS GGA
+		p->pos_pending = true;
+		return epoch_commit(p, fix);
+
+	case UBX_NAV_VELNED:
+		if (p->length != 36) break;
+		p->vel_itow = rd_u32(&b[0]);
+		p->vel_speed_mmps = (int32_t)(rd_u32(&b[20]) * 10); // gSpeed, CM/S
+		p->vel_course_cdeg = heading_cdeg(rd_i32(&b[24]));
+		p->vel_pending = true;
+		return epoch_commit(p, fix);
+
+	case UBX_NAV_SOL: {
+		if (p->length != 52) break;
+		uint8_t type = fix_type_gsa(b[10]);
+		p->sol_itow = rd_u32(&b[0]);
+		p->sol_seen = true;
+		p->sol_ok = (b[11] & 0x01) && (type >= 2); // gpsFixOK
+		fix->fix_type = type;
+		fix->rmc_valid = p->sol_ok;
+		fix->quality = p->sol_ok ? 1 : 0;
+		fix->sats = b[47];
+		return UBX_STATUS | epoch_commit(p, fix);
+	}
+
+	case UBX_NAV_TIMEUTC:
+		if (p->length != 20) break;
+		if (!(b[19] & 0x04)) break; // validUTC
+		set_utc(fix, rd_u16(&b[12]), b[14], b[15], b[16], b[17], b[18], rd_i32(&b[8]));
+		return UBX_TIME;
+
+	case UBX_NAV_PVT: {
+		if (p->length != 92) break;
+		uint8_t done = UBX_STATUS;
+		uint8_t type = fix_type_gsa(b[20]);
+		bool ok = (b[21] & 0x01) && (type >= 2); // gnssFixOK
+		fix->fix_type = type;
+		fix->rmc_valid = ok;
+		fix->quality = ok ? 1 : 0;
+		fix->sats = b[23];
+		if ((b[11] & 0x03) == 0x03){ // validDate AND validTime
+			set_utc(fix, rd_u16(&b[4]), b[6], b[7], b[8], b[9], b[10], rd_i32(&b[16]));
+			done |= UBX_TIME;
+		}
+		if (ok){
+			fix->lon_e7 = rd_i32(&b[24]);
+			fix->lat_e7 = rd_i32(&b[28]);
+			fix->alt_mm = rd_i32(&b[36]);
+			fix->speed_mmps = rd_i32(&b[60]); // gSpeed, ALREADY MM/S
+			fix->course_cdeg = heading_cdeg(rd_i32(&b[64]));
+			done |= UBX_POS | UBX_VEL;
+		}
+		return done;
+	}
+
+	default:
+		break;
+	}
+	return 0;
+}
+
+static uint8_t frame_commit(ubx_parser_t *p, gps_fix_t *fix){
+	p->frames++;
+	if (p->cls == UBX_CLASS_NAV){
+		return nav_message(p, fix);
+	}
+	if ((p->cls == UBX_CLASS_ACK) && (p->length == 2)){
+		p->ack_cls = p->payload[0];
+		p->ack_id = p->payload[1];
+		p->ack_ok = (p->id == UBX_ACK_ACK);
+		return UBX_ACK;
+	}
+	return 0;
+}
+
+static void checksum_add(ubx_parser_t *p, uint8_t c){
+	p->ck_a += c;
+	p->ck_b += p->ck_a;
+}
+
+uint8_t ubx_feed(ubx_parser_t *p, uint8_t c, gps_fix_t *fix){
+	switch (p->state){
+	case UBX_ST_SYNC1:
+		if (c == UBX_SYNC1){
+			p->state = UBX_ST_SYNC2;
+		}
+		break;
+
+	case UBX_ST_SYNC2:
+		if (c == UBX_SYNC2){
+			p->ck_a = 0;
+			p->ck_b = 0;
+			p->state = UBX_ST_CLASS;
+		}
+		else if (c != UBX_SYNC1){
+			p->state = UBX_ST_SYNC1;
+		}
+		break;
+
+	case UBX_ST_CLASS:
+		checksum_add(p, c);
+		p->cls = c;
+		p->state = UBX_ST_ID;
+		break;
+
+	case UBX_ST_ID:
+		checksum_add(p, c);
+		p->id = c;
+		p->state = UBX_ST_LEN1;
+		break;
+
+	case UBX_ST_LEN1:
+		checksum_add(p, c);
+		p->length = c;
+		p->state = UBX_ST_LEN2;
+		break;
+
+	case UBX_ST_LEN2:
+		checksum_add(p, c);
+		p->length |= (uint16_t)(c << 8);
+		p->index = 0;
+		if (p->length > UBX_MAX_PAYLOAD){
+			p->errors++; // NOTHING WE DECODE IS THIS LONG; LIKELY A FALSE SYNC, RESYNC NOW
+			p->state = UBX_ST_SYNC1;
+		}
+		else{
+			p->state = (p->length > 0) ? UBX_ST_PAYLOAD : UBX_ST_CK_A;
+		}
+		break;
+
+	case UBX_ST_PAYLOAD:
+		checksum_add(p, c);
+		p->payload[p->index++] = c;
+		if (p->index >= p->length){
+			p->state = UBX_ST_CK_A;
+		}
+		break;
+
+	case UBX_ST_CK_A:
+		if (c != p->ck_a){
+			p->errors++;
+			p->state = (c == UBX_SYNC1) ? UBX_ST_SYNC2 : UBX_ST_SYNC1;
+		}
+		else{
+			p->state = UBX_ST_CK_B;
+		}
+		break;
+
+	case UBX_ST_CK_B:
+		p->state = UBX_ST_SYNC1;
+		if (c != p->ck_b){
+			p->errors++;
+			break;
+		}
+		return frame_commit(p, fix);
+
+	default:
+		p->state = UBX_ST_SYNC1;
+		break;
+	}
+	return 0;
+}
+
+uint16_t ubx_build(uint8_t *out, uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len){
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+
+	out[0] = UBX_SYNC1;
+	out[1] = UBX_SYNC2;
+	out[2] = cls;
+	out[3] = id;
+	out[4] = (uint8_t)(len & 0xFF);
+	out[5] = (uint8_t)(len >> 8);
+	if (len > 0){
+		memcpy(&out[6], payload, len);
+	}
+	for (uint16_t i = 2; i < (uint16_t)(6 + len); i++){
+		ck_a += out[i];
+		ck_b += ck_a;
+	}
+	out[6 + len] = ck_a;
+	out[7 + len] = ck_b;
+	return (uint16_t)(len + UBX_FRAME_OVERHEAD);
+}
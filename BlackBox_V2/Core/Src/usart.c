@@ -27,6 +27,12 @@
 UART_HandleTypeDef huart4;
 UART_HandleTypeDef huart3;
 UART_HandleTypeDef huart2;
+/* USER CODE BEGIN UART_DMA */
+/* GPS stream runs on DMA1 (UART4_RX Stream2, channel 4) in circular mode */
+DMA_HandleTypeDef hdma_uart4_rx;
+/* Trace output on DMA1 (USART2_TX Stream6, channel 4), started by trace.c */
+DMA_HandleTypeDef hdma_usart2_tx;
+/* USER CODE END UART_DMA */
 
 /* UART4 init function */
 void MX_UART4_Init(void)
@@ -88,6 +94,7 @@ void MX_USART3_UART_Init(void)
 
 /* USER CODE BEGIN 1 */
 #include <string.h>
+#include "trace.h"
 
 void MX_USART2_UART_Init(void)
 {
@@ -103,11 +110,60 @@ void MX_USART2_UART_Init(void)
   {
     Error_Handler();
   }
+  /* Console input: RXNE only; output goes through the trace ring and DMA */
+  __HAL_UART_ENABLE_IT(&huart2, UART_IT_RXNE);
+  HAL_NVIC_SetPriority(USART2_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(USART2_IRQn);
 }
 
+/* Queued as a free-text trace entry: never waits on the UART, dropped if the ring is full */
 void DBG_Print(const char *s)
 {
-  HAL_UART_Transmit(&huart2, (uint8_t *)s, (uint16_t)strlen(s), HAL_MAX_DELAY);
+  trace_text(s);
+}
+
+/* One command line at a time; bytes arriving before it is read are dropped */
+static char dbg_rx_line[DBG_LINE_MAX];
+static uint8_t dbg_rx_len = 0;
+static volatile bool dbg_rx_ready = false;
+
+void DBG_RxISR(void)
+{
+  uint32_t sr = USART2->SR;
+  if (!(sr & (USART_SR_RXNE | USART_SR_ORE)))
+  {
+    return;
+  }
+  char c = (char)(USART2->DR & 0xFF); // SR THEN DR READ CLEARS RXNE AND ORE
+  if (dbg_rx_ready)
+  {
+    return;
+  }
+  if ((c == '\r') || (c == '\n'))
+  {
+    if (dbg_rx_len > 0)
+    {
+      dbg_rx_line[dbg_rx_len] = '\0';
+      dbg_rx_ready = true;
+    }
+  }
+  else if (dbg_rx_len < (DBG_LINE_MAX - 1))
+  {
+    dbg_rx_line[dbg_rx_len++] = c;
+  }
+}
+
+bool DBG_ReadLine(char *out, uint32_t size)
+{
+  if (!dbg_rx_ready || (size == 0))
+  {
+    return false;
+  }
+  strncpy(out, dbg_rx_line, size - 1);
+  out[size - 1] = '\0';
+  dbg_rx_len = 0;
+  dbg_rx_ready = false; // RE-ARMS THE ISR
+  return true;
 }
 /* USER CODE END 1 */
 
@@ -137,6 +193,29 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
 
   /* USER CODE BEGIN UART4_MspInit 1 */
 
+    /* UART4 DMA Init */
+    /* UART4_RX Init */
+    hdma_uart4_rx.Instance = DMA1_Stream2;
+    hdma_uart4_rx.Init.Channel = DMA_CHANNEL_4;
+    hdma_uart4_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_uart4_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_uart4_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_uart4_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_uart4_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_uart4_rx.Init.Mode = DMA_CIRCULAR;
+    hdma_uart4_rx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_uart4_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_uart4_rx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmarx,hdma_uart4_rx);
+
+    /* UART4 interrupt Init (IDLE line and error events) */
+    HAL_NVIC_SetPriority(UART4_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(UART4_IRQn);
+
   /* USER CODE END UART4_MspInit 1 */
   }
   else if(uartHandle->Instance==USART3)
@@ -181,6 +260,22 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
     GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* USART2_TX Init */
+    hdma_usart2_tx.Instance = DMA1_Stream6;
+    hdma_usart2_tx.Init.Channel = DMA_CHANNEL_4;
+    hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart2_tx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_usart2_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_usart2_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
   }
 }
 
@@ -202,6 +297,8 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_0|GPIO_PIN_1);
 
   /* USER CODE BEGIN UART4_MspDeInit 1 */
+    HAL_DMA_DeInit(uartHandle->hdmarx);
+    HAL_NVIC_DisableIRQ(UART4_IRQn);
 
   /* USER CODE END UART4_MspDeInit 1 */
   }
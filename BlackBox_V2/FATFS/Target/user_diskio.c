@@ -35,14 +35,36 @@
 /* Includes ------------------------------------------------------------------*/
 #include <string.h>
 #include "ff_gen_drv.h"
+#include "user_diskio.h"
 #include <stdbool.h>
 #include "spi.h"
+#include "prof.h"
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+#define SD_SECTOR_SIZE     512
+#define SD_DMA_TIMEOUT_MS  100   // 512 B at the 351 kHz init clock is ~12 ms
+#define SD_SPI_FAST_HZ     11250000UL   // data SCK ceiling: /8 of 90 MHz, /4 of 45 MHz
 /* Private variables ---------------------------------------------------------*/
 /* Disk status */
 static volatile DSTATUS Stat = STA_NOINIT;
 static bool block_addressing = false;
+
+/* 0xFF source clocked out while the card streams a read sector over DMA */
+static uint8_t sd_ff_block[SD_SECTOR_SIZE];
+
+/* Set from the SPI1 DMA callbacks, polled by SD_DMA_Wait */
+static volatile bool sd_dma_done = false;
+static volatile bool sd_dma_error = false;
+
+/*
+ * Write-behind: USER_write returns once the card has accepted the last block
+ * and leaves it programming with CS released. SD_IO_Poll advances the busy
+ * check a few bytes at a time from the main loop; any other disk access waits
+ * it out first through SD_FinishPending.
+ */
+static bool sd_card_busy = false;
+static bool sd_busy_error = false;
+static uint32_t sd_busy_start = 0;
 /* USER CODE END DECL */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -140,6 +162,335 @@ uint8_t SD_ReadR1(void){
     return rx;
 }
 
+/* Smallest SPI1 divider that keeps SCK at or under SD_SPI_FAST_HZ for the current APB2 clock */
+static uint32_t SD_FastPrescaler(void)
+{
+	uint32_t pclk2 = HAL_RCC_GetPCLK2Freq();
+	uint32_t br = 0;
+	while ((br < 7U) && ((pclk2 >> (br + 1U)) > SD_SPI_FAST_HZ)){
+		br++;
+	}
+	return br << SPI_CR1_BR_Pos;
+}
+
+/* After an APB2 prescaler change; the slow init clock is set again by USER_initialize */
+void SD_SPI_ClockUpdate(void)
+{
+	if ((Stat & STA_NOINIT) || (hspi1.State != HAL_SPI_STATE_READY)){
+		return;
+	}
+	hspi1.Init.BaudRatePrescaler = SD_FastPrescaler();
+	HAL_SPI_Init(&hspi1);
+}
+
+/*
+ * Single byte exchange straight on the SPI1 registers. Token and busy polling
+ * clock thousands of these per sector, and a HAL_SPI_TransmitReceive call per
+ * byte costs more than the byte itself at 11 MHz.
+ */
+static uint8_t SD_SpiByte(uint8_t tx)
+{
+	SPI_TypeDef *spi = hspi1.Instance;
+	if ((spi->CR1 & SPI_CR1_SPE) == 0){
+		__HAL_SPI_ENABLE(&hspi1);
+	}
+	while ((spi->SR & SPI_SR_TXE) == 0){
+	}
+	*(__IO uint8_t *)&spi->DR = tx;
+	while ((spi->SR & SPI_SR_RXNE) == 0){
+	}
+	return *(__IO uint8_t *)&spi->DR;
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+	if (hspi->Instance == SPI1){
+		sd_dma_done = true;
+	}
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+	if (hspi->Instance == SPI1){
+		sd_dma_done = true;
+	}
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+	if (hspi->Instance == SPI1){
+		sd_dma_error = true;
+		sd_dma_done = true;
+	}
+}
+
+/*
+ * Wait for the DMA completion flag. The calling task still spends the whole
+ * sector time here (~364 us at 11.25 MHz SCK) and no other task runs; what DMA
+ * buys is that the CAN RX interrupt can preempt without stretching or
+ * corrupting the transfer, and no per-byte loop runs on the core. The ring
+ * absorbs the frames that arrive meanwhile (about one at 2500 frames/s).
+ */
+#if SD_DMA_ENABLE
+static bool SD_DMA_Wait(void)
+{
+	uint32_t start = HAL_GetTick();
+	while (!sd_dma_done){
+		if ((HAL_GetTick() - start) > SD_DMA_TIMEOUT_MS){
+			HAL_SPI_Abort(&hspi1);
+			return false;
+		}
+	}
+	return !sd_dma_error;
+}
+#endif
+
+/* Clock one 512 B data block in from the card (data token already consumed) */
+static bool SD_ReceiveBlock(BYTE *dst)
+{
+	PROF_START(SD_SECTOR);
+#if SD_DMA_ENABLE
+	sd_dma_done = false;
+	sd_dma_error = false;
+	if (HAL_SPI_TransmitReceive_DMA(&hspi1, sd_ff_block, dst, SD_SECTOR_SIZE) != HAL_OK){
+		return false;
+	}
+	bool ok = SD_DMA_Wait();
+#else
+	for (int i = 0; i < SD_SECTOR_SIZE; i++){
+		dst[i] = SD_SpiByte(0xFF);
+	}
+	bool ok = true;
+#endif
+	PROF_STOP(SD_SECTOR);
+	return ok;
+}
+
+/* Clock one 512 B data block out to the card. TX only: HAL clears the RX overrun at the end */
+static bool SD_TransmitBlock(const BYTE *src)
+{
+	PROF_START(SD_SECTOR);
+#if SD_DMA_ENABLE
+	sd_dma_done = false;
+	sd_dma_error = false;
+	if (HAL_SPI_Transmit_DMA(&hspi1, (uint8_t *)src, SD_SECTOR_SIZE) != HAL_OK){
+		return false;
+	}
+	bool ok = SD_DMA_Wait();
+#else
+	for (int i = 0; i < SD_SECTOR_SIZE; i++){
+		SD_SpiByte(src[i]);
+	}
+	bool ok = true;
+#endif
+	PROF_STOP(SD_SECTOR);
+	return ok;
+}
+
+/* Wait for DO to go high (card not busy) */
+static bool SD_WaitReady(uint32_t timeout_ms)
+{
+	uint32_t start = HAL_GetTick();
+	while (SD_SpiByte(0xFF) != 0xFF){
+		if ((HAL_GetTick() - start) > timeout_ms){
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Hand the card back to the caller while it programs the last block */
+static void SD_BeginBusy(void)
+{
+	sd_card_busy = true;
+	sd_busy_start = HAL_GetTick();
+}
+
+/* Blocking fallback: settle an outstanding write before the next command */
+static bool SD_FinishPending(void)
+{
+	if (!sd_card_busy){
+		return true;
+	}
+	uint32_t elapsed = HAL_GetTick() - sd_busy_start;
+	uint32_t remaining = (elapsed < SD_BUSY_TIMEOUT_MS) ? (SD_BUSY_TIMEOUT_MS - elapsed) : 0;
+	SD_Select();
+	bool ready = SD_WaitReady(remaining);
+	SD_Deselect();
+	sd_card_busy = false;
+	if (!ready){
+		sd_busy_error = true; // ALSO SURFACED THROUGH SD_IO_Poll
+	}
+	return ready;
+}
+
+/* Data token + 512 B + CRC for one block of a CMD17/CMD18 read */
+static bool SD_ReadDataBlock(BYTE *dst)
+{
+	uint8_t token = 0xFF;
+	uint32_t start = HAL_GetTick();
+	while (token != 0xFE){
+		token = SD_SpiByte(0xFF);
+		if ((HAL_GetTick() - start) > 200){
+			return false;
+		}
+	}
+
+	if (!SD_ReceiveBlock(dst)){
+		return false;
+	}
+
+	SD_SpiByte(0xFF); // DISCARD 16-BIT CRC
+	SD_SpiByte(0xFF);
+	return true;
+}
+
+/* Start token + 512 B + CRC for one block of a CMD24/CMD25 write, without waiting out busy */
+static bool SD_SendDataBlock(const BYTE *src, uint8_t token)
+{
+	SD_SpiByte(token); // 0xFE SINGLE, 0xFC MULTI-BLOCK
+	if (!SD_TransmitBlock(src)){
+		return false;
+	}
+
+	SD_SpiByte(0xFF); // SEND DUMMY CRC BYTES
+	SD_SpiByte(0xFF);
+	uint8_t data_response = SD_SpiByte(0xFF); // CHECKING DATA RESPONSE TOKEN
+	return (data_response & 0x1F) == 0x05; // 0X05 = DATA ACCEPTED
+}
+
+/*
+ * ACMD23 (SET_WR_BLK_ERASE_COUNT) ahead of CMD25 lets the card pre-erase the
+ * whole run instead of erasing block by block. CS is released between CMD55
+ * and CMD23 for the same reason as CMD55/ACMD41 in USER_initialize. Failure is
+ * not fatal: the multi-block write still works without the hint.
+ */
+static void SD_PreErase(UINT count)
+{
+	SD_Select();
+	SD_Dummy();
+	SD_SendCommand(55, 0x00000000, 0x01);
+	uint8_t response = SD_ReadR1();
+	SD_Deselect();
+	if (response > 0x01){
+		return;
+	}
+
+	SD_Select();
+	SD_Dummy();
+	SD_SendCommand(23, count & 0x007FFFFF, 0x01);
+	SD_ReadR1();
+	SD_Deselect();
+}
+
+/* CMD24 for one sector, ACMD23 + CMD25 for a run; the card is left programming */
+static DRESULT SD_WriteBlocks(const BYTE *buff, DWORD sector, UINT count)
+{
+	if (!SD_FinishPending()){
+		return RES_ERROR;
+	}
+
+	uint32_t address = block_addressing ? sector : (sector * 512);
+
+	if (count == 1){
+		SD_Select(); // CS LOW
+		SD_SendCommand(24, address, 0x01); // CMD24 WRITE_BLOCK
+		if (SD_ReadR1() != 0x00){ // wait for R1 before sending data token
+			SD_Deselect();
+			return RES_ERROR;
+		}
+		bool ok = SD_SendDataBlock(buff, 0xFE);
+		SD_Deselect(); // CS high, CARD KEEPS PROGRAMMING
+		if (!ok){
+			return RES_ERROR;
+		}
+		SD_BeginBusy();
+		return RES_OK;
+	}
+
+	/*
+	 * Cluster-sized f_write: one CMD25 for the whole run so the card pays
+	 * command overhead once, with ACMD23 pre-erase to shorten per-block busy.
+	 */
+	SD_PreErase(count);
+
+	SD_Select();
+	SD_SendCommand(25, address, 0x01); // CMD25 WRITE_MULTIPLE_BLOCK
+	if (SD_ReadR1() != 0x00){
+		SD_Deselect();
+		return RES_ERROR;
+	}
+
+	bool ok = true;
+	for (UINT s = 0; s < count; s++){
+		if (!SD_SendDataBlock(buff + s * SD_SECTOR_SIZE, 0xFC)){
+			ok = false;
+			break;
+		}
+		/*
+		 * The card programs each block before taking the next, and that busy
+		 * is waited out here; only the tail is deferred. ACMD23 pre-erase is
+		 * meant to keep it short, but it is card-dependent and not measured on
+		 * this board yet: the sd_blk_busy probe reports it. Callers keep count
+		 * at or under SD_WRITE_BURST_MAX to bound the total.
+		 */
+		if (s + 1 < count){
+			PROF_START(SD_BLK_BUSY);
+			bool ready = SD_WaitReady(SD_BUSY_TIMEOUT_MS);
+			PROF_STOP(SD_BLK_BUSY);
+			if (!ready){
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	SD_SpiByte(0xFD); // STOP TRAN TOKEN, ALSO SENT AFTER A FAILED BLOCK
+	SD_SpiByte(0xFF); // ONE BYTE BEFORE BUSY IS SIGNALLED
+	SD_Deselect(); // CS high, CARD KEEPS PROGRAMMING
+	SD_BeginBusy();
+	return ok ? RES_OK : RES_ERROR;
+}
+
+/**
+  * @brief  Advance the card busy check without blocking
+  * @retval sd_io_state_t: SD_IO_ERROR is returned once per timed-out write
+  */
+sd_io_state_t SD_IO_Poll(void)
+{
+	if (sd_busy_error){
+		sd_busy_error = false;
+		return SD_IO_ERROR;
+	}
+	if (!sd_card_busy){
+		return SD_IO_IDLE;
+	}
+
+	SD_Select();
+	for (int i = 0; i < 4; i++){ // A FEW BYTES PER CALL, ~3 US AT 11 MHZ
+		if (SD_SpiByte(0xFF) == 0xFF){
+			sd_card_busy = false;
+			break;
+		}
+	}
+	SD_Deselect();
+
+	if (!sd_card_busy){
+		return SD_IO_IDLE;
+	}
+	if ((HAL_GetTick() - sd_busy_start) > SD_BUSY_TIMEOUT_MS){
+		sd_card_busy = false;
+		return SD_IO_ERROR;
+	}
+	return SD_IO_BUSY;
+}
+
+/* Card still programming, or an error not yet collected by SD_IO_Poll; no bus traffic */
+bool SD_IO_Pending(void)
+{
+	return sd_card_busy || sd_busy_error;
+}
+
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -161,6 +512,9 @@ DSTATUS USER_initialize (
 	(void)pdrv;
 	Stat = STA_NOINIT;
 	block_addressing = false;
+	sd_card_busy = false;
+	sd_busy_error = false;
+	memset(sd_ff_block, 0xFF, sizeof(sd_ff_block));
 
 	HAL_Delay(10);
 
@@ -286,7 +640,7 @@ DSTATUS USER_initialize (
 		}
 	}
 
-	hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_8;
+	hspi1.Init.BaudRatePrescaler = SD_FastPrescaler();
 	hspi1.Init.CLKPolarity = SPI_POLARITY_HIGH;
 	hspi1.Init.CLKPhase = SPI_PHASE_2EDGE;
 	HAL_SPI_Init(&hspi1);
@@ -330,39 +684,52 @@ DRESULT USER_read (
   /* USER CODE BEGIN READ */
 	(void)pdrv;
 
-	for (int s = 0; s < count; s++){
-		uint32_t address = block_addressing ? (sector + s): ((sector + s) * 512);
+	if (!SD_FinishPending()){
+		return RES_ERROR;
+	}
+
+	uint32_t address = block_addressing ? sector : (sector * 512);
 
+	if (count == 1){
 		SD_Select();
 		SD_Dummy();
-		SD_SendCommand(17, address, 0x01);
+		SD_SendCommand(17, address, 0x01); // CMD17 READ_SINGLE_BLOCK
 		if (SD_ReadR1() != 0x00){
 			SD_Deselect();
 			return RES_ERROR;
 		}
+		bool ok = SD_ReadDataBlock(buff);
+		SD_Deselect();
+		return ok ? RES_OK : RES_ERROR;
+	}
 
-		uint8_t tx = 0xFF, token = 0xFF;
-		uint32_t start = HAL_GetTick();
-		while (token != 0xFE){
-			HAL_SPI_TransmitReceive(&hspi1, &tx, &token, 1, HAL_MAX_DELAY);
-			if ((HAL_GetTick()-start) > 200){
-				SD_Deselect();
-				return RES_ERROR;
-			}
-		}
+	/* One CMD18 streams the whole run; CMD12 ends it */
+	SD_Select();
+	SD_Dummy();
+	SD_SendCommand(18, address, 0x01); // CMD18 READ_MULTIPLE_BLOCK
+	if (SD_ReadR1() != 0x00){
+		SD_Deselect();
+		return RES_ERROR;
+	}
 
-		uint8_t tx_dummy[512];
-		for (int i = 0; i < 512; i++){
-			tx_dummy[i] = 0xFF;
+	bool ok = true;
+	for (UINT s = 0; s < count; s++){
+		if (!SD_ReadDataBlock(buff + s * SD_SECTOR_SIZE)){
+			ok = false;
+			break;
 		}
-		HAL_SPI_TransmitReceive(&hspi1, tx_dummy, buff + s * 512, 512, HAL_MAX_DELAY);
+	}
 
-		uint8_t tx2[2] = {0xFF, 0XFF};
-		uint8_t crc_dummy[2];
-		HAL_SPI_TransmitReceive(&hspi1, tx2, crc_dummy, 2, HAL_MAX_DELAY);
-		SD_Deselect();
+	SD_SendCommand(12, 0x00000000, 0x01); // CMD12 STOP_TRANSMISSION
+	SD_SpiByte(0xFF); // STUFF BYTE FOLLOWING CMD12
+	if (SD_ReadR1() != 0x00){
+		ok = false;
 	}
-	return RES_OK;
+	if (!SD_WaitReady(200)){
+		ok = false;
+	}
+	SD_Deselect();
+	return ok ? RES_OK : RES_ERROR;
   /* USER CODE END READ */
 }
 
@@ -383,48 +750,12 @@ DRESULT USER_write (
 )
 {
   /* USER CODE BEGIN WRITE */
-  /* USER CODE HERE */
 	(void)pdrv;
 
-	for (int s = 0; s <count; s++){
-		uint32_t address = block_addressing ? (sector + s): ((sector + s) * 512);
-
-		SD_Select(); // CS LOW
-		SD_SendCommand(24, address, 0x01); // CMD24
-		if (SD_ReadR1() != 0x00){ // wait for R1 before sending data token
-			SD_Deselect();
-			return RES_ERROR;
-		}
-
-		uint8_t token = 0xFE;
-		uint8_t rx_dummy;
-		uint8_t rx_buffer_512[512];
-
-		HAL_SPI_TransmitReceive(&hspi1, &token, &rx_dummy, 1, HAL_MAX_DELAY); // SENDING DATA START TOKEN
-		HAL_SPI_TransmitReceive(&hspi1, (uint8_t*)(buff + s * 512), rx_buffer_512, 512, HAL_MAX_DELAY); // SEND ACTUAL DATA
-
-		uint8_t tx2[2] = {0xFF, 0XFF};
-		uint8_t rx2[2];
-		HAL_SPI_TransmitReceive(&hspi1, tx2, rx2, 2, HAL_MAX_DELAY); // SEND DUMMY CRC BYTE IN EXCHANGE FOR DATA RESPONSE
-		uint8_t tx = 0xFF, data_response; // CHECKING DATA RESPONSE TOKEN
-		HAL_SPI_TransmitReceive(&hspi1, &tx, &data_response, 1, HAL_MAX_DELAY);
-		if ((data_response & 0x1F) != 0x05){ // 0X05 = DATA ACCEPTED
-			SD_Deselect();
-			return RES_ERROR;
-		}
-		// ALLOW CARD TO FINISH WRITES (DO low while busy)
-		uint8_t busy = 0x00;
-		uint32_t start = HAL_GetTick();
-		while (busy == 0x00){
-			HAL_SPI_TransmitReceive(&hspi1, &tx, &busy, 1, HAL_MAX_DELAY);
-			if ((HAL_GetTick() - start) > 500){ // WRITES TAKE LONGER THAN READS
-				SD_Deselect();
-				return RES_ERROR;
-			}
-		}
-		SD_Deselect(); // CS high
-	}
-	return RES_OK;
+	PROF_START(SD_WRITE);
+	DRESULT res = SD_WriteBlocks(buff, sector, count);
+	PROF_STOP(SD_WRITE);
+	return res;
   /* USER CODE END WRITE */
 }
 #endif /* _USE_WRITE == 1 */
@@ -446,8 +777,8 @@ DRESULT USER_ioctl (
   /* USER CODE BEGIN IOCTL */
 	    (void)pdrv;
 	    switch (cmd){
-	        case CTRL_SYNC:
-	            return RES_OK;
+	        case CTRL_SYNC: // f_sync/f_close: NOTHING MAY STILL BE PROGRAMMING
+	            return SD_FinishPending() ? RES_OK : RES_ERROR;
 	        case GET_SECTOR_SIZE:
 	            *(WORD*)buff = 512;
 	            return RES_OK;
@@ -29,11 +29,37 @@
 /* USER CODE BEGIN 0 */
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
 /* Exported types ------------------------------------------------------------*/
+/* Card programming state after a write has been handed off */
+typedef enum {
+	SD_IO_IDLE,		// CARD READY FOR THE NEXT COMMAND
+	SD_IO_BUSY,		// LAST WRITE STILL PROGRAMMING (DO LOW)
+	SD_IO_ERROR		// BUSY OUTLASTED SD_BUSY_TIMEOUT_MS, REPORTED ONCE
+} sd_io_state_t;
+
 /* Exported constants --------------------------------------------------------*/
+#define SD_BUSY_TIMEOUT_MS 500
+
+/*
+ * Longest run one USER_write should be handed. Every block but the last waits
+ * out its programming busy inside the call, so the caller bounds its f_write
+ * size to keep one call inside its task budget.
+ */
+#define SD_WRITE_BURST_MAX 4
+
+/* 1: sector data phase on SPI1 DMA, 0: polled byte loop; compare the two with the sd_sector probe */
+#ifndef SD_DMA_ENABLE
+#define SD_DMA_ENABLE 1
+#endif
+
 /* Exported functions ------------------------------------------------------- */
 extern Diskio_drvTypeDef  USER_Driver;
 
+sd_io_state_t SD_IO_Poll(void);
+bool SD_IO_Pending(void);
+void SD_SPI_ClockUpdate(void);
+
 /* USER CODE END 0 */
 
 #ifdef __cplusplus
@@ -0,0 +1,21 @@
+/*
+ * crash.h (host test stub)
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// NO BACKUP SRAM ON THE HOST: THE BREADCRUMBS GO NOWHERE
+
+#ifndef TESTS_STUBS_CRASH_H_
+#define TESTS_STUBS_CRASH_H_
+
+#include <stdint.h>
+
+#define CRASH_NO_TASK 0xFF
+
+static inline void crash_task(uint8_t index){
+	(void)index;
+}
+
+#endif /* TESTS_STUBS_CRASH_H_ */
@@ -0,0 +1,38 @@
+/*
+ * main.h (host test stub)
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// STANDS IN FOR THE CUBE main.h SO FIRMWARE SOURCES BUILD ON THE HOST
+
+#ifndef TESTS_STUBS_MAIN_H_
+#define TESTS_STUBS_MAIN_H_
+
+#include <stdint.h>
+
+/* Full fence: at least as strong as the Cortex-M DMB the firmware relies on */
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __WFI() ((void)0)
+
+/* Core debug registers as plain memory; a test advances CYCCNT itself */
+typedef struct {
+	uint32_t CTRL;
+	uint32_t CYCCNT;
+} stub_dwt_t;
+
+typedef struct {
+	uint32_t DEMCR;
+} stub_core_debug_t;
+
+extern stub_dwt_t stub_dwt;
+extern stub_core_debug_t stub_core_debug;
+extern uint32_t SystemCoreClock;
+
+#define DWT       (&stub_dwt)
+#define CoreDebug (&stub_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+#endif /* TESTS_STUBS_MAIN_H_ */
@@ -0,0 +1,84 @@
+/*
+ * spi.h (host test stub)
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// SPI1 AS user_diskio.c SEES IT: HANDLE, HAL CALLS AND A REGISTER BLOCK WHOSE ACCESSES A TEST CAN OBSERVE
+
+#ifndef TESTS_STUBS_SPI_H_
+#define TESTS_STUBS_SPI_H_
+
+#include "stm32f4xx_hal.h"
+
+/*
+ * CR1, SR and DR are one-element arrays indexed through stub_spi_access(), so
+ * every `spi->SR` in the driver calls into the test first. The test counts
+ * the access, charges its bus time and updates the register before the
+ * driver's load or store goes through.
+ */
+typedef enum {
+	STUB_SPI_CR1,
+	STUB_SPI_SR,
+	STUB_SPI_DR
+} stub_spi_reg_t;
+
+typedef struct {
+	__IO uint32_t CR1_reg[1];
+	__IO uint32_t SR_reg[1];
+	__IO uint32_t DR_reg[1];
+} SPI_TypeDef;
+
+uint32_t stub_spi_access(stub_spi_reg_t reg);	// RETURNS 0
+
+#define CR1 CR1_reg[stub_spi_access(STUB_SPI_CR1)]
+#define SR  SR_reg[stub_spi_access(STUB_SPI_SR)]
+#define DR  DR_reg[stub_spi_access(STUB_SPI_DR)]
+
+#define SPI_CR1_SPE    (1UL << 6)
+#define SPI_CR1_BR_Pos 3U
+#define SPI_SR_RXNE    (1UL << 0)
+#define SPI_SR_TXE     (1UL << 1)
+
+#define SPI_BAUDRATEPRESCALER_256 (7UL << SPI_CR1_BR_Pos)
+#define SPI_POLARITY_LOW  0U
+#define SPI_POLARITY_HIGH 2U
+#define SPI_PHASE_1EDGE   0U
+#define SPI_PHASE_2EDGE   1U
+
+typedef enum {
+	HAL_SPI_STATE_RESET = 0,
+	HAL_SPI_STATE_READY,
+	HAL_SPI_STATE_BUSY
+} HAL_SPI_StateTypeDef;
+
+typedef struct {
+	uint32_t BaudRatePrescaler;
+	uint32_t CLKPolarity;
+	uint32_t CLKPhase;
+} SPI_InitTypeDef;
+
+typedef struct {
+	SPI_TypeDef *Instance;
+	SPI_InitTypeDef Init;
+	__IO HAL_SPI_StateTypeDef State;
+} SPI_HandleTypeDef;
+
+extern SPI_TypeDef stub_spi1;
+extern SPI_HandleTypeDef hspi1;
+
+#define SPI1 (&stub_spi1)
+
+#define __HAL_SPI_ENABLE(h) ((h)->Instance->CR1 |= SPI_CR1_SPE)
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint16_t size);
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi);
+
+#endif /* TESTS_STUBS_SPI_H_ */
@@ -0,0 +1,45 @@
+/*
+ * stm32f4xx_hal.h (host test stub)
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// THE HAL CALLS THE FATFS TARGET CODE MAKES OUTSIDE SPI; A TEST DEFINES THEM ON ITS OWN SIMULATED CLOCK
+
+#ifndef TESTS_STUBS_STM32F4XX_HAL_H_
+#define TESTS_STUBS_STM32F4XX_HAL_H_
+
+#include "main.h"
+
+#define __IO volatile
+
+typedef enum {
+	HAL_OK = 0,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+typedef struct {
+	uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum {
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+/* Enough for the SD card CS pin in the Cube main.h (CS_SPI1 on PC12) */
+extern GPIO_TypeDef stub_gpioc;
+#define GPIOC       (&stub_gpioc)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+#endif /* TESTS_STUBS_STM32F4XX_HAL_H_ */
@@ -0,0 +1,21 @@
+/*
+ * timebase.h (host test stub)
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// SIMULATED 1 MHZ TIMEBASE: THE TEST OWNS THE CLOCK
+
+#ifndef TESTS_STUBS_TIMEBASE_H_
+#define TESTS_STUBS_TIMEBASE_H_
+
+#include <stdint.h>
+
+extern uint32_t stub_now_us;
+
+static inline uint32_t timebase_now_us(void){
+	return stub_now_us;
+}
+
+#endif /* TESTS_STUBS_TIMEBASE_H_ */
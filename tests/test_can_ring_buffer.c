@@ -0,0 +1,130 @@
+/*
+ * test_can_ring_buffer.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// HOST STRESS TEST: ONE PRODUCER THREAD FOR THE CAN RX ISR, ONE CONSUMER THREAD FOR THE DRAIN
+//
+// gcc -O2 -pthread -Itests/stubs -IBlackBox_V2/Core/Inc tests/test_can_ring_buffer.c BlackBox_V2/Core/Src/can_ring_buffer.c -o /tmp/test_can_ring_buffer && /tmp/test_can_ring_buffer
+
+#include "can_ring_buffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_FRAMES   4000000U
+#define TEST_CAPACITY 32U		// CAN_RB_CAPACITY
+
+/* Frames per time slice: the consumer is slower, so the ring runs both full and empty */
+#define TEST_PRODUCER_BURST 24U
+#define TEST_CONSUMER_BURST 20U
+
+static can_frame_t test_storage[TEST_CAPACITY];
+static can_ring_buffer_t test_rb;
+static uint8_t *test_dropped;	// PRODUCER: 1 FOR EVERY SEQUENCE NUMBER THE RING REFUSED
+static volatile int test_producer_done = 0;
+static uint32_t test_failures = 0;
+
+/* Every byte is derived from the sequence number, so a torn or stale slot shows up */
+static void test_fill(can_frame_t *f, uint32_t seq){
+	f->id = seq;
+	f->dlc = (uint8_t)(seq & 7U) + 1U;
+	for (int i = 0; i < 8; i++){
+		f->data[i] = (uint8_t)(seq >> (i & 3) * 8) ^ (uint8_t)i;
+	}
+	f->timestamp = ~seq;
+}
+
+static int test_check(const can_frame_t *f, uint32_t seq){
+	can_frame_t want;
+	test_fill(&want, seq);
+	return (f->dlc == want.dlc) && (memcmp(f->data, want.data, 8) == 0) && (f->timestamp == want.timestamp);
+}
+
+static void *test_producer(void *arg){
+	(void)arg;
+	for (uint32_t seq = 0; seq < TEST_FRAMES; seq++){
+		if ((seq % TEST_PRODUCER_BURST) == 0){
+			sched_yield(); // ALSO INTERLEAVES THE TWO SIDES ON A SINGLE-CORE HOST
+		}
+		can_frame_t *slot = CANRingBuffer_Claim(&test_rb);
+		if (slot == NULL){
+			test_dropped[seq] = 1;
+			continue;
+		}
+		test_fill(slot, seq);
+		CANRingBuffer_Commit(&test_rb);
+	}
+	__atomic_store_n(&test_producer_done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+int main(void){
+	test_dropped = calloc(TEST_FRAMES, 1);
+	if ((test_dropped == NULL) || !CANRingBuffer_Init(&test_rb, TEST_CAPACITY, test_storage)){
+		printf("FAIL: setup\n");
+		return 1;
+	}
+
+	pthread_t producer;
+	pthread_create(&producer, NULL, test_producer, NULL);
+
+	uint32_t received = 0;
+	uint32_t next = 0;		// LOWEST SEQUENCE NUMBER STILL EXPECTED
+	uint32_t spins = 0;
+	for (;;){
+		const can_frame_t *f = CANRingBuffer_Peek(&test_rb);
+		if (f == NULL){
+			if (__atomic_load_n(&test_producer_done, __ATOMIC_ACQUIRE) && (CANRingBuffer_Count(&test_rb) == 0)){
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+		uint32_t seq = f->id;
+		if ((seq < next) || (seq >= TEST_FRAMES)){
+			printf("FAIL: out of order, got %u expected >= %u\n", seq, next);
+			test_failures++;
+			break;
+		}
+		if (!test_check(f, seq)){
+			printf("FAIL: frame %u corrupted\n", seq);
+			test_failures++;
+		}
+		/* Everything skipped since the last frame must be a drop the producer saw; it set the flag before committing seq */
+		for (uint32_t s = next; s < seq; s++){
+			if (!test_dropped[s]){
+				printf("FAIL: frame %u lost without a drop\n", s);
+				test_failures++;
+			}
+		}
+		next = seq + 1;
+		received++;
+		CANRingBuffer_Release(&test_rb);
+		if ((++spins % TEST_CONSUMER_BURST) == 0){
+			sched_yield();
+		}
+	}
+	pthread_join(producer, NULL);
+
+	uint32_t dropped_flags = 0;
+	for (uint32_t s = 0; s < TEST_FRAMES; s++){
+		dropped_flags += test_dropped[s];
+	}
+	if (received + test_rb.dropped_count != TEST_FRAMES){
+		printf("FAIL: %u received + %u dropped != %u sent\n", received, test_rb.dropped_count, TEST_FRAMES);
+		test_failures++;
+	}
+	if (dropped_flags != test_rb.dropped_count){
+		printf("FAIL: dropped_count %u, producer saw %u refusals\n", test_rb.dropped_count, dropped_flags);
+		test_failures++;
+	}
+	printf("%s: %u frames, %u received, %u dropped\n", test_failures ? "FAIL" : "PASS",
+	       TEST_FRAMES, received, test_rb.dropped_count);
+	free(test_dropped);
+	return test_failures ? 1 : 0;
+}
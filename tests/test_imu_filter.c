@@ -0,0 +1,122 @@
+/*
+ * test_imu_filter.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// HOST TEST: imu_filter.c (PAIRED SMLAD DOT PRODUCT, DOUBLED HISTORY, POLYPHASE) BIT-EXACT AGAINST A DIRECT-FORM REFERENCE
+//
+// gcc -O2 -Itests/stubs -IBlackBox_V2/Core/Inc tests/test_imu_filter.c BlackBox_V2/Core/Src/imu_filter.c -o /tmp/test_imu_filter && /tmp/test_imu_filter
+// Other ratios: add -DIMU_LOG_RATE_HZ=500, 250 or 100 (decimation 2, 4, 10)
+
+#include "imu_filter.h"
+#include "imu_filter_taps.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if IMU_FILTER_DECIMATION <= 1
+#error "build with a decimating IMU_LOG_RATE_HZ"
+#endif
+
+#define TEST_SAMPLES 200000
+#define TEST_CHANNELS 6
+
+static int16_t test_in[TEST_CHANNELS][TEST_SAMPLES];
+static uint32_t test_failures = 0;
+
+/* The spec, written the obvious way: 64-bit sum over the last TAPS inputs (zeros before the first), round, saturate */
+static int16_t ref_output(const int16_t *x, int newest){
+	int64_t acc = 0;
+	for (int k = 0; k < IMU_FILTER_TAPS; k++){
+		int i = newest - (IMU_FILTER_TAPS - 1) + k;
+		if (i >= 0){
+			acc += (int64_t)imu_filter_coeffs[k] * x[i];
+		}
+	}
+	acc = (acc + (1 << 14)) >> 15;
+	if (acc > INT16_MAX){
+		return INT16_MAX;
+	}
+	if (acc < INT16_MIN){
+		return INT16_MIN;
+	}
+	return (int16_t)acc;
+}
+
+/* Random noise, full-scale steps, and the input that drives the accumulator hardest (sign of each tap at full scale) */
+static void test_fill(int ch, uint32_t *seed){
+	for (int i = 0; i < TEST_SAMPLES; i++){
+		int16_t v;
+		int segment = (i / 5000) % 4;
+		*seed = *seed * 1664525U + 1013904223U;
+		if (segment == 0){
+			v = (int16_t)(*seed >> 16);
+		}
+		else if (segment == 1){
+			v = ((i / 37) & 1) ? INT16_MAX : INT16_MIN;
+		}
+		else if (segment == 2){
+			int16_t c = imu_filter_coeffs[(IMU_FILTER_TAPS - 1) - (i % IMU_FILTER_TAPS)];
+			v = (c < 0) ? INT16_MIN : INT16_MAX;
+		}
+		else{
+			v = (int16_t)((*seed >> 20) - 2048 + ch * 1000); // SMALL SIGNAL AROUND AN OFFSET
+		}
+		test_in[ch][i] = v;
+	}
+}
+
+/* Feed [start, end) through imu_filter_push and compare every output; the reference sees the same history */
+static uint32_t test_run(int start, int end){
+	uint32_t outputs = 0;
+	for (int i = start; i < end; i++){
+		imu_frame in = {
+			test_in[0][i], test_in[1][i], test_in[2][i], test_in[3][i], test_in[4][i], test_in[5][i],
+			(int16_t)i, 1000000U + (uint32_t)i * 1000U
+		};
+		imu_frame out;
+		bool ready = imu_filter_push(&in, &out);
+		bool want_ready = ((i - start + 1) % IMU_FILTER_DECIMATION) == 0;
+		if (ready != want_ready){
+			printf("FAIL: sample %d output %d, expected %d\n", i, ready, want_ready);
+			test_failures++;
+			continue;
+		}
+		if (!ready){
+			continue;
+		}
+		const int16_t got[TEST_CHANNELS] = { out.accel_x, out.accel_y, out.accel_z, out.gyro_x, out.gyro_y, out.gyro_z };
+		for (int ch = 0; ch < TEST_CHANNELS; ch++){
+			int16_t want = ref_output(&test_in[ch][start], i - start);
+			if (got[ch] != want){
+				if (test_failures < 10){
+					printf("FAIL: sample %d channel %d: %d, reference %d\n", i, ch, got[ch], want);
+				}
+				test_failures++;
+			}
+		}
+		if ((out.temp != in.temp) || (out.timestamp != in.timestamp - IMU_FILTER_DELAY_US)){
+			printf("FAIL: sample %d temp/timestamp not carried\n", i);
+			test_failures++;
+		}
+		outputs++;
+	}
+	return outputs;
+}
+
+int main(void){
+	uint32_t seed = 12345;
+	for (int ch = 0; ch < TEST_CHANNELS; ch++){
+		test_fill(ch, &seed);
+	}
+
+	imu_filter_init();
+	uint32_t outputs = test_run(0, TEST_SAMPLES / 2);
+	imu_filter_reset(); // NEW SESSION: HISTORY AND PHASE START OVER
+	outputs += test_run(TEST_SAMPLES / 2, TEST_SAMPLES);
+
+	printf("%s: decimation %d, %u outputs x %d channels compared\n", test_failures ? "FAIL" : "PASS",
+	       IMU_FILTER_DECIMATION, outputs, TEST_CHANNELS);
+	return test_failures ? 1 : 0;
+}
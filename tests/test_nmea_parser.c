@@ -0,0 +1,230 @@
+/*
+ * test_nmea_parser.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// HOST TEST: NMEA PARSER FUZZ LOOP, EXACT NUMERIC FIELDS UP TO NMEA_MANTISSA_MAX, BYTES-PER-SECOND BENCHMARK
+//
+// gcc -O2 -g -fsanitize=address,undefined -Itests/stubs -IBlackBox_V2/Core/Inc tests/test_nmea_parser.c BlackBox_V2/Core/Src/nmea_parser.c -o /tmp/test_nmea_parser && /tmp/test_nmea_parser
+// Drop the sanitizers for a representative throughput figure
+
+#include "nmea_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_FUZZ_ROUNDS   2000000U
+#define TEST_SPEED_ROUNDS  200000U
+#define TEST_CORPUS_BYTES  (4U * 1024U * 1024U)
+#define TEST_BENCH_SECONDS 1.0
+
+static const char *const test_valid[] = {
+	"$GPRMC,123519.25,A,4807.0381,N,01131.0002,E,022.4,084.4,230394,003.1,W",
+	"$GNGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,",
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A",
+	"$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1",
+	"$GLRMC,235959.999,A,8959.9999999,S,17959.9999999,W,0.0,359.99,311299,,",
+	"$GPGGA,000000,0000.0000,N,00000.0000,E,2,12,99.99,-412.5,M,,M,,",
+};
+#define TEST_VALID_COUNT (sizeof(test_valid) / sizeof(test_valid[0]))
+
+static uint32_t test_failures = 0;
+static uint32_t test_rng = 12345;
+
+static uint32_t test_rand(void){
+	test_rng ^= test_rng << 13;
+	test_rng ^= test_rng >> 17;
+	test_rng ^= test_rng << 5;
+	return test_rng;
+}
+
+/* "$body" -> "$body*HH\r\n" */
+static int test_sentence(char *out, const char *body){
+	uint8_t ck = 0;
+	for (const char *c = body + 1; *c; c++){
+		ck ^= (uint8_t)*c;
+	}
+	return sprintf(out, "%s*%02X\r\n", body, ck);
+}
+
+static void test_feed(nmea_parser_t *p, const char *s, int len, gps_fix_t *fix){
+	uint8_t done = nmea_feed_span(p, (const uint8_t *)s, (uint16_t)len, fix);
+	if (done & ~(NMEA_RMC | NMEA_GGA | NMEA_VTG | NMEA_GSA)){
+		printf("FAIL: nmea_feed returned 0x%02X\n", done);
+		test_failures++;
+	}
+}
+
+/* What any byte stream must leave behind: bounded parser state, committed fields in range */
+static void test_invariants(const nmea_parser_t *p, const gps_fix_t *fix, uint32_t round){
+	bool ok = (p->length <= NMEA_MAX_LEN + 1) && (p->type_len <= sizeof(p->type)) &&
+	          (p->frac_digits <= NMEA_MAX_FRAC) && (p->mantissa <= NMEA_MANTISSA_MAX * 10 + 9) &&
+	          (fix->lat_e7 >= -900000000) && (fix->lat_e7 <= 900000000) &&
+	          (fix->lon_e7 >= -1800000000) && (fix->lon_e7 <= 1800000000) &&
+	          (fix->time_ms <= 86400999U);
+	if (!ok && (test_failures < 10)){
+		printf("FAIL: round %u: state or fix out of range (len %u frac %u mantissa %llu lat %d lon %d time %u)\n", round,
+		       p->length, p->frac_digits, (unsigned long long)p->mantissa, fix->lat_e7, fix->lon_e7, fix->time_ms);
+	}
+	test_failures += !ok;
+}
+
+/* Random bytes, and valid sentences with bytes flipped, dropped, repeated or the checksum recomputed after */
+static void test_fuzz(void){
+	nmea_parser_t p;
+	gps_fix_t fix;
+	char body[160];
+	char out[200];
+	nmea_init(&p);
+	memset(&fix, 0, sizeof(fix));
+
+	for (uint32_t round = 0; round < TEST_FUZZ_ROUNDS; round++){
+		uint32_t mode = test_rand() % 4;
+		int len;
+		if (mode == 0){
+			len = 1 + (int)(test_rand() % 120);
+			for (int i = 0; i < len; i++){
+				uint32_t r = test_rand();
+				out[i] = (r & 0x100) ? (char)r : ",.*$-0123456789ANSEW\r\n"[r % 22]; // HALF FROM THE NMEA ALPHABET
+			}
+		}
+		else{
+			strcpy(body, test_valid[test_rand() % TEST_VALID_COUNT]);
+			int n = (int)strlen(body);
+			int edits = 1 + (int)(test_rand() % 4);
+			for (int e = 0; e < edits; e++){
+				int at = 1 + (int)(test_rand() % (uint32_t)(n - 1));
+				uint32_t r = test_rand();
+				if ((r % 3 == 0) && (n < 120)){
+					memmove(&body[at + 1], &body[at], (size_t)(n - at + 1)); // INSERT A DIGIT: LONG NUMBERS
+					body[at] = (char)('0' + (r >> 8) % 10);
+					n++;
+				}
+				else if ((r % 3 == 1) && (n > 2)){
+					memmove(&body[at], &body[at + 1], (size_t)(n - at));
+					n--;
+				}
+				else{
+					body[at] = (char)(r >> 8);
+					if (body[at] == 0){
+						body[at] = ',';
+					}
+				}
+			}
+			if (mode == 1){
+				len = sprintf(out, "%s*00\r\n", body); // CHECKSUM ALMOST ALWAYS WRONG
+			}
+			else{
+				len = test_sentence(out, body); // CHECKSUM VALID: FIELDS REACH THE FIX
+			}
+		}
+		test_feed(&p, out, len, &fix);
+		test_invariants(&p, &fix, round);
+	}
+	printf("fuzz: %u rounds, %u parser errors\n", TEST_FUZZ_ROUNDS, p.errors);
+}
+
+/* RMC knots with any digit count: committed exactly (128-bit reference) up to NMEA_MANTISSA_MAX, dropped above it */
+static void test_speed(void){
+	nmea_parser_t p;
+	gps_fix_t fix;
+	char body[120];
+	char out[160];
+	char digits[24];
+	nmea_init(&p);
+	memset(&fix, 0, sizeof(fix));
+
+	for (uint32_t round = 0; round < TEST_SPEED_ROUNDS; round++){
+		int ndig = 1 + (int)(test_rand() % 20);
+		int point = (int)(test_rand() % (uint32_t)(ndig + 1)); // DIGITS BEFORE THE '.', ndig = NONE
+		unsigned __int128 m = 0;
+		int frac = 0;
+		int k = 0;
+		for (int i = 0; i < ndig; i++){
+			if (i == point){
+				digits[k++] = '.';
+			}
+			int d = (int)(test_rand() % 10);
+			digits[k++] = (char)('0' + d);
+			if ((i >= point) && (frac >= NMEA_MAX_FRAC)){
+				continue; // DROPPED BY THE PARSER
+			}
+			frac += (i >= point);
+			m = m * 10 + (unsigned)d;
+		}
+		digits[k] = 0;
+		snprintf(body, sizeof(body), "$GPRMC,123519,A,4807.038,N,01131.000,E,%s,084.4,230394,,", digits);
+		int len = test_sentence(out, body);
+
+		fix.speed_mmps = -12345;
+		test_feed(&p, out, len, &fix);
+
+		int32_t want = -12345;
+		if (m <= NMEA_MANTISSA_MAX){
+			unsigned __int128 den = 3600;
+			for (int i = 0; i < frac; i++){
+				den *= 10;
+			}
+			want = (int32_t)(uint32_t)(uint64_t)((m * 1852000U + den / 2) / den);
+		}
+		if (fix.speed_mmps != want){
+			if (test_failures < 10){
+				printf("FAIL: speed \"%s\" -> %d, expected %d\n", digits, fix.speed_mmps, want);
+			}
+			test_failures++;
+		}
+	}
+	printf("speed: %u long-field sentences checked\n", TEST_SPEED_ROUNDS);
+}
+
+static double test_seconds(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Valid sentences back to back, fed in DMA-sized spans like gps_driver.c does */
+static void test_bench(void){
+	char *corpus = malloc(TEST_CORPUS_BYTES + 200);
+	uint32_t len = 0;
+	uint32_t sentences = 0;
+	while (len < TEST_CORPUS_BYTES){
+		len += (uint32_t)test_sentence(&corpus[len], test_valid[sentences++ % TEST_VALID_COUNT]);
+	}
+
+	nmea_parser_t p;
+	gps_fix_t fix;
+	nmea_init(&p);
+	memset(&fix, 0, sizeof(fix));
+	uint64_t bytes = 0;
+	uint32_t commits = 0;
+	double start = test_seconds();
+	double elapsed;
+	do {
+		for (uint32_t at = 0; at < len; at += 512){
+			uint32_t n = (len - at < 512) ? (len - at) : 512;
+			commits += (nmea_feed_span(&p, (const uint8_t *)&corpus[at], (uint16_t)n, &fix) != 0);
+		}
+		bytes += len;
+		elapsed = test_seconds() - start;
+	} while (elapsed < TEST_BENCH_SECONDS);
+
+	if (p.errors != 0){
+		printf("FAIL: %u parser errors on the valid corpus\n", p.errors);
+		test_failures++;
+	}
+	printf("bench: %.1f MB/s, %.0f sentences/s (host, %u-byte corpus, %u spans committed)\n",
+	       (double)bytes / elapsed / 1e6, (double)bytes / elapsed * sentences / len, len, commits);
+	free(corpus);
+}
+
+int main(void){
+	test_fuzz();
+	test_speed();
+	test_bench();
+	printf("%s\n", test_failures ? "FAIL" : "PASS");
+	return test_failures ? 1 : 0;
+}
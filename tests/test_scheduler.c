@@ -0,0 +1,171 @@
+/*
+ * test_scheduler.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// HOST TEST: THE app_tasks TABLE ON A SIMULATED TIMEBASE: NO LATE START AT TYPICAL OR FULL-BUDGET COSTS, WATCHDOG REFRESH NEVER WITHHELD
+//
+// gcc -O2 -Itests/stubs -IBlackBox_V2/Core/Inc tests/test_scheduler.c BlackBox_V2/Core/Src/scheduler.c -o /tmp/test_scheduler && /tmp/test_scheduler
+
+#include "scheduler.h"
+#include "tasks.h"
+#include "main.h"
+#include "timebase.h"
+#include <stdio.h>
+
+stub_dwt_t stub_dwt;
+stub_core_debug_t stub_core_debug;
+uint32_t SystemCoreClock = 180000000U;
+uint32_t stub_now_us;
+
+#define MS(x) ((x) * 1000UL)
+#define TEST_IDLE_STEP_US 10U		// CLOCK ADVANCE PER WFI
+
+static uint32_t test_refreshed, test_withheld;
+static uint32_t test_last_refresh, test_max_refresh_gap;
+static uint32_t test_failures = 0;
+static bool test_full_budget;		// EVERY RUN COSTS ITS WHOLE BUDGET
+
+static const sched_task_t test_app_tasks[TASK_COUNT];
+
+/* A task body costs simulated time: the clock and the cycle counter move together */
+static void test_cost(uint32_t us){
+	stub_now_us += us;
+	stub_dwt.CYCCNT += us * (SystemCoreClock / 1000000U);
+}
+
+/* Typical cost, or the task's budget from the table in the full-budget run */
+static void test_run(task_id_t id, uint32_t us){
+	test_cost(test_full_budget ? test_app_tasks[id].budget_us : us);
+}
+
+static void test_task_can(void){
+	static uint32_t runs;
+	test_run(TASK_CAN, ((++runs % 50) == 0) ? 500 : 150); // NOW AND THEN A FULL 32-FRAME PASS
+}
+
+static void test_task_imu(void){ test_run(TASK_IMU, 120); }
+static void test_task_gps(void){ test_run(TASK_GPS, 300); }
+static void test_task_logger(void){ test_run(TASK_LOGGER, 150); }
+
+static void test_task_sd(void){
+	static uint32_t runs;
+	test_run(TASK_SD, ((++runs % 4) == 0) ? 4000 : 30); // A 2 KB BURST EVERY 40 MS, ~50 KB/S LOGGED
+}
+
+static void test_task_ui(void){
+	static uint32_t runs;
+	test_run(TASK_UI, ((++runs % 25) == 0) ? 1000 : 150); // EVERY 5 S A "prof" DUMP
+}
+
+/* task_health without the IWDG: count what it would have done */
+static void test_task_health(void){
+	if (scheduler_check_in_all()){
+		uint32_t gap = stub_now_us - test_last_refresh;
+		if ((test_refreshed > 0) && (gap > test_max_refresh_gap)){
+			test_max_refresh_gap = gap;
+		}
+		test_last_refresh = stub_now_us;
+		test_refreshed++;
+	}
+	else{
+		test_withheld++;
+	}
+	test_run(TASK_HEALTH, 20);
+}
+
+static void test_hog(void){ test_cost(1200); } // LONGER THAN ITS 1 MS PERIOD: ALWAYS DUE
+
+/* The firmware table itself, with test bodies in place of task_can and the rest */
+static const sched_task_t test_app_tasks[TASK_COUNT] = {
+#define TEST_TASK(id, name, body, period, offset, deadline, budget) [TASK_##id] = {name, test_##body, period, offset, deadline, budget},
+	APP_TASKS(TEST_TASK)
+#undef TEST_TASK
+};
+
+/* A hog above ui starves it; health sits above the hog so it still runs and must notice */
+static const sched_task_t test_starved_tasks[] = {
+	{"can",    test_task_can,    MS(2),   0,      MS(5),  500},
+	{"health", test_task_health, MS(100), MS(25), MS(50), 50},
+	{"hog",    test_hog,         MS(1),   0,      MS(1),  1000},
+	{"ui",     test_task_ui,     MS(200), MS(50), MS(50), 1000},
+};
+
+static void test_start(const sched_task_t *tasks, uint8_t count, uint32_t now){
+	stub_now_us = now;
+	test_refreshed = 0;
+	test_withheld = 0;
+	test_max_refresh_gap = 0;
+	scheduler_init(tasks, count);
+}
+
+static void test_run_for(uint32_t us){
+	uint32_t start = stub_now_us;
+	while ((stub_now_us - start) < us){
+		if (!scheduler_dispatch()){
+			test_cost(TEST_IDLE_STEP_US);
+		}
+	}
+}
+
+static void test_expect(bool ok, const char *what){
+	if (!ok){
+		printf("FAIL: %s\n", what);
+		test_failures++;
+	}
+}
+
+/* Every task of app_tasks started within its deadline of every release */
+static void test_expect_on_time(const char *run){
+	for (uint8_t i = 0; i < TASK_COUNT; i++){
+		const sched_stats_t *st = scheduler_stats(i);
+		if (st->late != 0){
+			printf("FAIL: %s: %s started late %u times, worst %u us after release (deadline %u us)\n", run,
+			       test_app_tasks[i].name, st->late, st->max_jitter_us, test_app_tasks[i].deadline_us);
+			test_failures++;
+		}
+	}
+	printf("%s: can worst start %u us, logger %u us, sd %u us after release\n", run, scheduler_stats(TASK_CAN)->max_jitter_us,
+	       scheduler_stats(TASK_LOGGER)->max_jitter_us, scheduler_stats(TASK_SD)->max_jitter_us);
+}
+
+int main(void){
+	/* Steady state for 10 minutes across a timebase wrap, with a STOP-mode gap and resync in the middle */
+	test_start(test_app_tasks, TASK_COUNT, 0xFFFFFFFFU - MS(30000));
+	test_run_for(MS(300000));
+	stub_now_us += MS(10000);
+	scheduler_resync();
+	test_last_refresh = stub_now_us; // THE SLEEPER FED THE WATCHDOG THROUGH THE GAP
+	test_run_for(MS(300000));
+
+	const sched_stats_t *ui = scheduler_stats(TASK_UI);
+	printf("steady: %u refreshes, %u withheld, longest refresh gap %u us, ui %u runs\n",
+	       test_refreshed, test_withheld, test_max_refresh_gap, ui->runs);
+	test_expect(test_withheld == 0, "refresh withheld in steady state");
+	test_expect(test_refreshed >= 5999, "health ran less than every 100 ms");
+	test_expect(test_max_refresh_gap <= MS(100) + MS(50), "refresh gap past the health period plus deadline");
+	test_expect(ui->runs >= 2999, "ui ran less than every 200 ms");
+	test_expect_on_time("steady");
+
+	/* Every task at its whole budget on every run: the deadlines must still hold */
+	test_full_budget = true;
+	test_start(test_app_tasks, TASK_COUNT, 0);
+	test_run_for(MS(60000));
+	test_full_budget = false;
+	printf("full budget: %u refreshes, %u withheld\n", test_refreshed, test_withheld);
+	test_expect(test_withheld == 0, "refresh withheld with every task at its budget");
+	test_expect_on_time("full budget");
+
+	/* A starved task must still stop the refresh once its own window has passed */
+	test_start(test_starved_tasks, 4, 0);
+	test_run_for(MS(2000));
+	printf("starved: %u refreshes, %u withheld, ui %u runs\n", test_refreshed, test_withheld, scheduler_stats(3)->runs);
+	test_expect(scheduler_stats(3)->runs == 0, "hog did not starve ui");
+	test_expect((test_refreshed > 0) && (test_refreshed <= 3), "refresh continued past ui's 250 ms window");
+	test_expect(test_withheld >= 15, "starved ui not reported");
+
+	printf("%s\n", test_failures ? "FAIL" : "PASS");
+	return test_failures ? 1 : 0;
+}
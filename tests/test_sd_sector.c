@@ -0,0 +1,439 @@
+/*
+ * test_sd_sector.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Sunny Lin
+ */
+
+// HOST BENCH: user_diskio.c SECTOR DATA PHASE, POLLED (SD_DMA_ENABLE=0) AGAINST DMA (=1), ON A SIMULATED SPI1 AND CARD
+//
+// for d in 0 1; do gcc -O2 -DSD_DMA_ENABLE=$d -Itests/stubs -IBlackBox_V2/Core/Inc -IBlackBox_V2/FATFS/Target -IBlackBox_V2/Middlewares/Third_Party/FatFs/src tests/test_sd_sector.c BlackBox_V2/FATFS/Target/user_diskio.c -o /tmp/test_sd_sector && /tmp/test_sd_sector || break; done
+
+#include "ff_gen_drv.h"
+#include "user_diskio.h"
+#include "prof.h"
+#include "spi.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Cost model in core cycles at the board's 90 MHz HCLK (APB2 also 90 MHz).
+ * The wire time follows the SPI1 prescaler the driver programs; the rest are
+ * estimates, not board measurements, and apply to both builds alike.
+ */
+#define BENCH_HCLK_HZ         90000000UL
+#define BENCH_APB_CYCLES      4U	// ONE SPI1 REGISTER LOAD OR STORE
+#define BENCH_SPIBYTE_CYCLES  10U	// CALL, LOOP AND BRANCHES OF ONE SD_SpiByte, BESIDES ITS REGISTER ACCESSES
+#define BENCH_POLL_CYCLES     8U	// ONE HAL_GetTick CALL, E.G. ONE SD_DMA_Wait ITERATION
+#define BENCH_HAL_CALL_CYCLES 150U	// ONE BLOCKING HAL_SPI_TransmitReceive, BESIDES THE WIRE TIME
+#define BENCH_DMA_START_CYCLES 400U	// HAL_SPI_*_DMA: STREAM SETUP FOR RX AND TX, SPI ENABLE
+#define BENCH_DMA_IRQ_CYCLES  300U	// HAL_DMA_IRQHandler, SPI END OF TRANSFER, CALLBACK
+#define BENCH_CAN_ISR_CYCLES  180U	// ONE CAN RX INTERRUPT (~2 US)
+#define BENCH_PROG_US         300U	// CARD BUSY AFTER EACH WRITTEN BLOCK
+
+#define BENCH_SECTORS 64U
+#define BENCH_RUNS    500U
+
+SPI_TypeDef stub_spi1;
+SPI_HandleTypeDef hspi1 = { .Instance = SPI1 };
+GPIO_TypeDef stub_gpioc;
+stub_dwt_t stub_dwt;
+stub_core_debug_t stub_core_debug;
+uint32_t SystemCoreClock = BENCH_HCLK_HZ;
+
+static uint32_t test_failures = 0;
+
+/* ---- Simulated clock and interrupts ---- */
+
+static uint64_t sim_cycles;
+static uint32_t sim_byte_cycles = 8U * 256U;	// UNTIL THE DRIVER PROGRAMS A PRESCALER
+static uint32_t sim_can_period;			// 0: NO CAN LOAD
+static uint64_t sim_can_next;
+static uint32_t sim_can_isrs;
+
+static bool sim_dma_active;
+static bool sim_dma_rx;
+static uint64_t sim_dma_end;
+static uint8_t *sim_dma_tx;
+static uint8_t *sim_dma_rxbuf;
+static uint16_t sim_dma_size;
+
+static uint8_t card_exchange(uint8_t tx);
+
+static void sim_advance(uint32_t cycles);
+
+/* DMA runs alongside the core: the bytes move when its end time passes, then the stream IRQ fires */
+static void sim_interrupts(void){
+	while ((sim_can_period != 0) && (sim_cycles >= sim_can_next)){
+		sim_cycles += BENCH_CAN_ISR_CYCLES;
+		sim_can_next += sim_can_period;
+		sim_can_isrs++;
+	}
+	if (sim_dma_active && (sim_cycles >= sim_dma_end)){
+		sim_dma_active = false;
+		for (uint16_t i = 0; i < sim_dma_size; i++){
+			uint8_t rx = card_exchange(sim_dma_tx[i]);
+			if (sim_dma_rx){
+				sim_dma_rxbuf[i] = rx;
+			}
+		}
+		hspi1.State = HAL_SPI_STATE_READY;
+		sim_advance(BENCH_DMA_IRQ_CYCLES);
+		if (sim_dma_rx){
+			HAL_SPI_TxRxCpltCallback(&hspi1);
+		}
+		else{
+			HAL_SPI_TxCpltCallback(&hspi1);
+		}
+	}
+}
+
+static void sim_advance(uint32_t cycles){
+	sim_cycles += cycles;
+	sim_interrupts();
+	stub_dwt.CYCCNT = (uint32_t)sim_cycles;
+}
+
+/* ---- SD card in SPI mode: SDHC, block addressing, every command accepted ---- */
+
+typedef enum {
+	CARD_IDLE,		// WATCHING FOR A COMMAND
+	CARD_CMD,		// COLLECTING THE 6-BYTE FRAME
+	CARD_WAIT_TOKEN,	// AFTER CMD24/CMD25: 0xFE / 0xFC STARTS A BLOCK, 0xFD ENDS CMD25
+	CARD_WRITE_DATA		// 512 DATA + 2 CRC
+} card_state_t;
+
+static uint8_t card_data[BENCH_SECTORS][512];
+static bool card_selected;
+static bool card_ready;		// ACMD41 SEEN SINCE THE LAST CMD0
+static bool card_app_cmd;	// LAST COMMAND WAS CMD55
+static card_state_t card_state = CARD_IDLE;
+static uint8_t card_cmd[6];
+static uint32_t card_cmd_len;
+static uint8_t card_out[520];
+static uint32_t card_out_len, card_out_pos;
+static bool card_multi;
+static uint32_t card_block;
+static uint32_t card_write_pos;
+static uint64_t card_busy_until;
+
+static void card_queue(const uint8_t *bytes, uint32_t len){
+	memcpy(&card_out[card_out_len], bytes, len);
+	card_out_len += len;
+}
+
+static void card_command(void){
+	uint8_t cmd = card_cmd[0] & 0x3F;
+	uint32_t arg = ((uint32_t)card_cmd[1] << 24) | ((uint32_t)card_cmd[2] << 16) | ((uint32_t)card_cmd[3] << 8) | card_cmd[4];
+	uint8_t r1 = card_ready ? 0x00 : 0x01;
+	card_out_len = 0;
+	card_out_pos = 0;
+	card_queue((const uint8_t[]){ 0xFF }, 1); // NCR
+
+	if (card_app_cmd && (cmd == 41)){
+		card_ready = true;
+		card_queue((const uint8_t[]){ 0x00 }, 1);
+	}
+	else if (cmd == 0){
+		card_ready = false;
+		card_queue((const uint8_t[]){ 0x01 }, 1);
+	}
+	else if (cmd == 8){
+		card_queue((const uint8_t[]){ r1, 0x00, 0x00, 0x01, (uint8_t)arg }, 5);
+	}
+	else if (cmd == 58){
+		card_queue((const uint8_t[]){ r1, 0xC0, 0xFF, 0x80, 0x00 }, 5); // CCS: BLOCK ADDRESSING
+	}
+	else if ((cmd == 17) && (arg < BENCH_SECTORS)){
+		card_queue((const uint8_t[]){ r1, 0xFF, 0xFF, 0xFE }, 4);
+		card_queue(card_data[arg], 512);
+		card_queue((const uint8_t[]){ 0x12, 0x34 }, 2);
+	}
+	else if (((cmd == 24) || (cmd == 25)) && (arg < BENCH_SECTORS)){
+		card_queue(&r1, 1);
+		card_multi = (cmd == 25);
+		card_block = arg;
+		card_state = CARD_WAIT_TOKEN;
+	}
+	else if ((cmd == 55) || (cmd == 23) || (cmd == 16)){
+		card_queue(&r1, 1);
+	}
+	else{
+		card_queue((const uint8_t[]){ 0x04 }, 1); // ILLEGAL COMMAND
+	}
+	card_app_cmd = (cmd == 55);
+}
+
+/* One byte each way on the bus: what the card drives on DO for the byte the host sent on DI */
+static uint8_t card_exchange(uint8_t tx){
+	if (!card_selected){
+		return 0xFF;
+	}
+	uint8_t rx = 0xFF;
+	if (card_out_pos < card_out_len){
+		rx = card_out[card_out_pos++];
+	}
+	else if (sim_cycles < card_busy_until){
+		rx = 0x00;
+	}
+
+	switch (card_state){
+	case CARD_IDLE:
+		if ((tx & 0xC0) == 0x40){
+			card_cmd[0] = tx;
+			card_cmd_len = 1;
+			card_state = CARD_CMD;
+		}
+		break;
+	case CARD_CMD:
+		card_cmd[card_cmd_len++] = tx;
+		if (card_cmd_len == 6){
+			card_state = CARD_IDLE;
+			card_command();
+		}
+		break;
+	case CARD_WAIT_TOKEN:
+		if ((tx == 0xFE) || (tx == 0xFC)){
+			card_write_pos = 0;
+			card_state = CARD_WRITE_DATA;
+		}
+		else if (tx == 0xFD){
+			card_out_len = card_out_pos = 0;
+			card_queue((const uint8_t[]){ 0xFF }, 1);
+			card_busy_until = sim_cycles + 2U * sim_byte_cycles + (uint64_t)BENCH_PROG_US * (BENCH_HCLK_HZ / 1000000U);
+			card_state = CARD_IDLE;
+		}
+		break;
+	case CARD_WRITE_DATA:
+		if (card_write_pos < 512){
+			card_data[card_block][card_write_pos] = tx;
+		}
+		if (++card_write_pos == 514){
+			card_out_len = card_out_pos = 0;
+			card_queue((const uint8_t[]){ 0xE5 }, 1); // DATA ACCEPTED
+			card_busy_until = sim_cycles + 2U * sim_byte_cycles + (uint64_t)BENCH_PROG_US * (BENCH_HCLK_HZ / 1000000U);
+			card_block++;
+			card_state = (card_multi && (card_block < BENCH_SECTORS)) ? CARD_WAIT_TOKEN : CARD_IDLE;
+		}
+		break;
+	}
+	return rx;
+}
+
+/* ---- HAL and register stubs ---- */
+
+static uint32_t spi_accesses;
+static uint32_t spi_sr_reads;	// TXE/RXNE POLLS: HOW MANY DEPENDS ON THE COST MODEL, THE REST ON THE DRIVER
+static bool spi_tx_pending;
+static bool spi_rx_full;
+static uint64_t spi_byte_end;
+
+/* A byte starts when DR is stored and is on DO once the prescaled SCK has clocked 8 bits */
+uint32_t stub_spi_access(stub_spi_reg_t reg){
+	spi_accesses++;
+	if (reg == STUB_SPI_CR1){
+		sim_advance(BENCH_SPIBYTE_CYCLES); // EVERY SD_SpiByte OPENS WITH THE SPE CHECK
+	}
+	sim_advance(BENCH_APB_CYCLES);
+	if (reg == STUB_SPI_SR){
+		spi_sr_reads++;
+		if (spi_tx_pending && (sim_cycles >= spi_byte_end)){
+			stub_spi1.DR_reg[0] = card_exchange((uint8_t)stub_spi1.DR_reg[0]);
+			spi_tx_pending = false;
+			spi_rx_full = true;
+		}
+		stub_spi1.SR_reg[0] = (spi_tx_pending ? 0 : SPI_SR_TXE) | (spi_rx_full ? SPI_SR_RXNE : 0);
+	}
+	else if (reg == STUB_SPI_DR){
+		if (spi_rx_full){
+			spi_rx_full = false; // THIS ACCESS IS THE READ
+		}
+		else{
+			spi_tx_pending = true; // THIS ACCESS IS THE WRITE
+			spi_byte_end = sim_cycles + sim_byte_cycles;
+		}
+	}
+	return 0;
+}
+
+uint32_t HAL_GetTick(void){
+	sim_advance(BENCH_POLL_CYCLES);
+	return (uint32_t)(sim_cycles / (BENCH_HCLK_HZ / 1000U));
+}
+
+void HAL_Delay(uint32_t ms){
+	sim_advance(ms * (BENCH_HCLK_HZ / 1000U));
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void){
+	return BENCH_HCLK_HZ;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state){
+	if ((port == CS_SPI1_GPIO_Port) && (pin == CS_SPI1_Pin)){
+		card_selected = (state == GPIO_PIN_RESET);
+		if (!card_selected){
+			card_out_len = card_out_pos = 0;
+			card_state = CARD_IDLE;
+		}
+	}
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi){
+	sim_byte_cycles = 8U * (2U << ((hspi->Init.BaudRatePrescaler >> SPI_CR1_BR_Pos) & 7U));
+	hspi->State = HAL_SPI_STATE_READY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi){
+	sim_dma_active = false;
+	hspi->State = HAL_SPI_STATE_READY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size, uint32_t timeout){
+	(void)hspi;
+	(void)timeout;
+	sim_advance(BENCH_HAL_CALL_CYCLES);
+	for (uint16_t i = 0; i < size; i++){
+		sim_advance(sim_byte_cycles);
+		rx[i] = card_exchange(tx[i]);
+	}
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef sim_dma_start(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size){
+	if (sim_dma_active){
+		return HAL_BUSY;
+	}
+	sim_advance(BENCH_DMA_START_CYCLES);
+	hspi->State = HAL_SPI_STATE_BUSY;
+	sim_dma_tx = tx;
+	sim_dma_rxbuf = rx;
+	sim_dma_rx = (rx != NULL);
+	sim_dma_size = size;
+	sim_dma_end = sim_cycles + (uint64_t)size * sim_byte_cycles; // BACK TO BACK, NO GAP BETWEEN BYTES
+	sim_dma_active = true;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size){
+	return sim_dma_start(hspi, tx, rx, size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint16_t size){
+	return sim_dma_start(hspi, tx, NULL, size);
+}
+
+/* The driver's own sd_sector probe, read on the simulated cycle counter */
+static uint32_t bench_dir;	// 0 READ, 1 WRITE
+static uint64_t bench_sector_sum[2];
+static uint32_t bench_sector_max[2];
+static uint32_t bench_sector_count[2];
+
+void prof_record(prof_id_t id, uint32_t cycles){
+	if (id != PROF_SD_SECTOR){
+		return;
+	}
+	bench_sector_sum[bench_dir] += cycles;
+	bench_sector_count[bench_dir]++;
+	if (cycles > bench_sector_max[bench_dir]){
+		bench_sector_max[bench_dir] = cycles;
+	}
+}
+
+/* ---- Bench ---- */
+
+static void test_expect(bool ok, const char *what){
+	if (!ok){
+		printf("FAIL: %s\n", what);
+		test_failures++;
+	}
+}
+
+static void test_pattern(uint8_t *buf, uint32_t sector, uint32_t round){
+	for (uint32_t i = 0; i < 512; i++){
+		buf[i] = (uint8_t)(i * 7U + sector * 13U + round * 31U);
+	}
+}
+
+/* Every sector written (CMD24, then 4-block CMD25 runs) and read back through the driver */
+static void test_round_trip(void){
+	uint8_t buf[4 * 512];
+	uint8_t back[512];
+	uint32_t mismatches = 0;
+
+	for (uint32_t s = 0; s < BENCH_SECTORS / 2; s++){
+		test_pattern(buf, s, 1);
+		test_expect(USER_Driver.disk_write(0, buf, s, 1) == RES_OK, "CMD24 write");
+	}
+	for (uint32_t s = BENCH_SECTORS / 2; s < BENCH_SECTORS; s += SD_WRITE_BURST_MAX){
+		for (uint32_t k = 0; k < SD_WRITE_BURST_MAX; k++){
+			test_pattern(&buf[k * 512], s + k, 1);
+		}
+		test_expect(USER_Driver.disk_write(0, buf, s, SD_WRITE_BURST_MAX) == RES_OK, "CMD25 write");
+	}
+	for (uint32_t s = 0; s < BENCH_SECTORS; s++){
+		test_pattern(buf, s, 1);
+		test_expect(USER_Driver.disk_read(0, back, s, 1) == RES_OK, "CMD17 read");
+		mismatches += (memcmp(buf, card_data[s], 512) != 0) + (memcmp(buf, back, 512) != 0);
+	}
+	test_expect(mismatches == 0, "sector data corrupted on the way to or from the card");
+	printf("round trip: %u sectors written and read back, %u mismatches\n", BENCH_SECTORS, mismatches);
+}
+
+/* CMD24 then CMD17 of one sector, BENCH_RUNS times, under a CAN RX interrupt rate */
+static void test_bench(uint32_t can_per_s, uint32_t acc[2], uint32_t sr[2]){
+	uint8_t buf[512];
+	uint8_t back[512];
+	memset(bench_sector_sum, 0, sizeof(bench_sector_sum));
+	memset(bench_sector_max, 0, sizeof(bench_sector_max));
+	memset(bench_sector_count, 0, sizeof(bench_sector_count));
+	sim_can_period = can_per_s ? (BENCH_HCLK_HZ / can_per_s) : 0;
+	sim_can_next = sim_cycles + 12345U; // NOT IN STEP WITH THE SECTORS
+	sim_can_isrs = 0;
+
+	for (uint32_t r = 0; r < BENCH_RUNS; r++){
+		uint32_t s = r % BENCH_SECTORS;
+		test_pattern(buf, s, r);
+		uint32_t before = spi_accesses, sr_before = spi_sr_reads;
+		bench_dir = 1;
+		test_expect(USER_Driver.disk_write(0, buf, s, 1) == RES_OK, "bench write");
+		acc[1] = spi_accesses - before;
+		sr[1] = spi_sr_reads - sr_before;
+		USER_Driver.disk_ioctl(0, CTRL_SYNC, NULL); // BUSY WAITED OUT HERE, NOT COUNTED IN THE READ
+		before = spi_accesses;
+		sr_before = spi_sr_reads;
+		bench_dir = 0;
+		test_expect(USER_Driver.disk_read(0, back, s, 1) == RES_OK, "bench read");
+		acc[0] = spi_accesses - before;
+		sr[0] = spi_sr_reads - sr_before;
+		test_expect(memcmp(buf, back, 512) == 0, "bench sector read back differs");
+	}
+	sim_can_period = 0;
+
+	const double us = 1e6 / (double)BENCH_HCLK_HZ;
+	printf("can %4u/s: read %6.1f us mean %6.1f max, write %6.1f us mean %6.1f max (%u can interrupts)\n", can_per_s,
+	       (double)bench_sector_sum[0] / bench_sector_count[0] * us, bench_sector_max[0] * us,
+	       (double)bench_sector_sum[1] / bench_sector_count[1] * us, bench_sector_max[1] * us, sim_can_isrs);
+}
+
+int main(void){
+	printf("SD_DMA_ENABLE=%d (%s): sd_sector probe on a simulated %lu MHz core\n", SD_DMA_ENABLE,
+	       SD_DMA_ENABLE ? "DMA" : "polled", BENCH_HCLK_HZ / 1000000UL);
+	test_expect(USER_Driver.disk_initialize(0) == 0, "card init");
+	printf("sck %.2f MHz, %.1f us of wire time per 512-byte sector\n", (double)BENCH_HCLK_HZ / (sim_byte_cycles / 8U) / 1e6,
+	       512.0 * sim_byte_cycles * 1e6 / (double)BENCH_HCLK_HZ);
+
+	test_round_trip();
+
+	uint32_t acc[2] = {0}, sr[2] = {0};
+	test_bench(0, acc, sr);
+	test_bench(2500, acc, sr);
+	test_bench(4000, acc, sr);
+	printf("spi1 register accesses by the core per 1-sector call: read %u (%u SR polls), write %u (%u SR polls)\n",
+	       acc[0], sr[0], acc[1], sr[1]);
+
+	printf("%s\n", test_failures ? "FAIL" : "PASS");
+	return test_failures ? 1 : 0;
+}
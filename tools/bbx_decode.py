@@ -0,0 +1,480 @@
+import argparse
+import bisect
+import calendar
+import struct
+import sys
+from pathlib import Path
+
+# Binary session log (.bbx) decoder. The layout is defined in
+# BlackBox_V2/Core/Inc/log_format.h; keep the two in sync.
+
+BBX_MAGIC = b"BBXL"
+# v1: millisecond ticks, v2: microsecond ticks (header carries the rate either way),
+# v3: SKIP records, v4: IMU6 records, v5: GPS records, v6: SYNC records, v7: DR records,
+# v8: PROF records, v9: CRASH records
+BBX_VERSIONS = (1, 2, 3, 4, 5, 6, 7, 8, 9)
+
+BBX_REC_CAN = 0x01
+BBX_REC_CAN_IMU = 0x02
+BBX_REC_IMU = 0x03
+BBX_REC_SKIP = 0x04
+BBX_REC_IMU6 = 0x05
+BBX_REC_GPS = 0x06
+BBX_REC_SYNC = 0x07
+BBX_REC_DR = 0x08
+BBX_REC_PROF = 0x09
+BBX_REC_CRASH = 0x0A
+BBX_REC_TIME = 0x10
+
+# Pseudo-ID the firmware writes on IMU-only rows when the bus is quiet
+IMU_ONLY_ID = 0xFFFF
+
+# CRASH record enums and fields, as in crash.h and fsm_sys.h
+RESET_CAUSES = ("power-on", "pin", "brownout", "software", "iwdg", "wwdg", "low-power")
+CRASH_KINDS = ("none", "hardfault", "Error_Handler")
+SYS_STATES = ("INIT", "IDLE", "LOGGING", "FAULT", "SHUTDOWN")
+CRASH_NO_TASK = 0xFF
+CRASH_FORMAT = "<BBBBBI8IIIIIIIIIIIIII"
+CRASH_FIELDS = (
+    "cause", "kind", "held", "state", "task", "uptime_ms", "r0", "r1", "r2", "r3", "r12", "lr", "pc", "xpsr",
+    "exc_return", "sp", "cfsr", "hfsr", "mmfar", "bfar", "can_head", "can_tail", "can_dropped",
+    "prio_head", "prio_tail", "prio_dropped", "staged",
+)
+
+
+class BbxFormatError(Exception):
+    pass
+
+
+def _parse_header(blob):
+    """Return (header_size, tick_hz, start_ts) after validating magic and version."""
+    if len(blob) < 16 or blob[:4] != BBX_MAGIC:
+        raise BbxFormatError("not a .bbx log (bad magic)")
+    version, header_size, _flags, tick_hz, start_ts = struct.unpack_from("<BBHII", blob, 4)
+    if version not in BBX_VERSIONS:
+        raise BbxFormatError(f"unsupported .bbx version {version} (decoder knows {BBX_VERSIONS})")
+    if header_size < 16 or tick_hz == 0:
+        raise BbxFormatError("corrupt .bbx header")
+    return header_size, tick_hz, start_ts
+
+
+def read_tick_hz(blob):
+    return _parse_header(blob)[1]
+
+
+def iter_records(
+    blob, skipped=None, imu_samples=None, gps_fixes=None, syncs=None, dr_points=None, profs=None, crashes=None
+):
+    """
+    Yield (timestamp, can_id, dlc, data_bytes, (ax, ay, az)) for every CAN or IMU row.
+    Timestamps are in header ticks, unwrapped past the firmware's 32-bit rollover.
+    The IMU triple is carried forward across records that did not repeat it.
+    Frames the logging policy suppressed are summed per ID into the optional skipped dict.
+    Full IMU6 samples (ts, ax, ay, az, gx, gy, gz, temp) are appended to the optional imu_samples list.
+    GPS fixes (ts, lat_e7, lon_e7, alt_mm, speed_mmps, course_cdeg, fix_type, locked, sats) are
+    appended to the optional gps_fixes list, still in the firmware's integer units.
+    PPS sync points (edge_ts, date_ddmmyy, utc_ms_of_day, drift_ppb) are appended to the optional syncs list.
+    Dead-reckoned points (ts, lat_e7, lon_e7, heading_cdeg, speed_cmps) are appended to the optional dr_points list.
+    Profiling intervals (ts, core_hz, probe, count, min, max, mean, first_bin, hist) are appended to the optional
+    profs list, with cycle counts as recorded.
+    Post-mortems of the previous run are appended to the optional crashes list as dicts keyed by CRASH_FIELDS.
+    A record truncated by power loss ends iteration quietly.
+    """
+    pos, _tick_hz, ts = _parse_header(blob)
+    imu = (0, 0, 0)
+    n = len(blob)
+
+    while pos < n:
+        rtype = blob[pos]
+        pos += 1
+
+        if rtype == BBX_REC_TIME:
+            if pos + 4 > n:
+                return
+            (absolute,) = struct.unpack_from("<I", blob, pos)
+            pos += 4
+            ts += (absolute - ts) & 0xFFFFFFFF  # forward to the next value congruent mod 2^32
+            continue
+
+        if rtype == BBX_REC_SKIP:
+            if pos + 4 > n:
+                return
+            can_id, count = struct.unpack_from("<HH", blob, pos)
+            pos += 4
+            if skipped is not None:
+                skipped[can_id] = skipped.get(can_id, 0) + count
+            continue
+
+        if rtype in (BBX_REC_CAN, BBX_REC_CAN_IMU):
+            if pos + 5 > n:
+                return
+            dt, can_id, dlc = struct.unpack_from("<HHB", blob, pos)
+            pos += 5
+            dlc = min(dlc, 8)
+            if pos + dlc > n:
+                return
+            data = bytes(blob[pos : pos + dlc])
+            pos += dlc
+            if rtype == BBX_REC_CAN_IMU:
+                if pos + 6 > n:
+                    return
+                imu = struct.unpack_from("<hhh", blob, pos)
+                pos += 6
+            ts += dt
+            yield ts, can_id, dlc, data, imu
+            continue
+
+        if rtype == BBX_REC_IMU:
+            if pos + 8 > n:
+                return
+            dt = struct.unpack_from("<H", blob, pos)[0]
+            imu = struct.unpack_from("<hhh", blob, pos + 2)
+            pos += 8
+            ts += dt
+            yield ts, IMU_ONLY_ID, 0, b"", imu
+            continue
+
+        if rtype == BBX_REC_IMU6:
+            if pos + 16 > n:
+                return
+            dt = struct.unpack_from("<H", blob, pos)[0]
+            channels = struct.unpack_from("<hhhhhhh", blob, pos + 2)
+            pos += 16
+            ts += dt
+            imu = channels[:3]
+            if imu_samples is not None:
+                imu_samples.append((ts,) + channels)
+            yield ts, IMU_ONLY_ID, 0, b"", imu
+            continue
+
+        if rtype == BBX_REC_DR:
+            if pos + 14 > n:
+                return
+            dt, lat, lon, heading, speed = struct.unpack_from("<HiiHH", blob, pos)
+            pos += 14
+            ts += dt
+            if dr_points is not None:
+                dr_points.append((ts, lat, lon, heading, speed))
+            continue
+
+        if rtype == BBX_REC_SYNC:
+            if pos + 16 > n:
+                return
+            edge, date, utc_ms, drift = struct.unpack_from("<IIIi", blob, pos)
+            pos += 16
+            if syncs is not None:
+                # The edge is absolute and may sit either side of the running time; unwrap it next to ts
+                delta = ((edge - ts + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+                syncs.append((ts + delta, date, utc_ms, drift))
+            continue
+
+        if rtype == BBX_REC_PROF:
+            if pos + 9 > n:
+                return
+            stamp, core_hz, name_len = struct.unpack_from("<IIB", blob, pos)
+            pos += 9
+            if pos + name_len + 18 > n:
+                return
+            probe = bytes(blob[pos : pos + name_len]).decode("ascii", "replace")
+            pos += name_len
+            count, lo, hi, mean, first, bins = struct.unpack_from("<IIIIBB", blob, pos)
+            pos += 18
+            if pos + 4 * bins > n:
+                return
+            hist = struct.unpack_from(f"<{bins}I", blob, pos)
+            pos += 4 * bins
+            if profs is not None:
+                delta = ((stamp - ts + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+                profs.append((ts + delta, core_hz, probe, count, lo, hi, mean, first, hist))
+            continue
+
+        if rtype == BBX_REC_CRASH:
+            size = struct.calcsize(CRASH_FORMAT)
+            if pos + size > n:
+                return
+            fields = struct.unpack_from(CRASH_FORMAT, blob, pos)
+            pos += size
+            if crashes is not None:
+                crashes.append(dict(zip(CRASH_FIELDS, fields)))
+            continue
+
+        if rtype == BBX_REC_GPS:
+            if pos + 22 > n:
+                return
+            dt, lat, lon, alt, speed, course, fix, sats = struct.unpack_from("<HiiiiHBB", blob, pos)
+            pos += 22
+            ts += dt
+            if gps_fixes is not None:
+                gps_fixes.append((ts, lat, lon, alt, speed, course, fix & 0x0F, bool(fix & 0x80), sats))
+            continue
+
+        raise BbxFormatError(f"unknown record type 0x{rtype:02X} at offset {pos - 1}")
+
+
+def format_csv_row(ts, can_id, dlc, data, imu):
+    """Same text the firmware's CSV mode writes: time,0xID,dlc,d0..d7,ax,ay,az"""
+    padded = list(data) + [0] * (8 - len(data))
+    fields = [str(ts), f"0x{can_id:03X}", str(dlc)]
+    fields += [str(b) for b in padded]
+    fields += [str(v) for v in imu]
+    return ",".join(fields)
+
+
+def utc_mapper(syncs, tick_hz):
+    """
+    Return f(ts) -> UTC microseconds since the Unix epoch, or None without a usable sync.
+    Between two PPS edges the mapping is linear, which absorbs the MCU clock's drift;
+    outside them it extrapolates from the nearest edge with that edge's drift estimate.
+    """
+    points = []
+    for edge, date, utc_ms, drift in syncs:
+        if date == 0:
+            continue  # CROSSED MIDNIGHT BEFORE A DATE WAS SEEN
+        day, month, year = date // 10000, (date // 100) % 100, 2000 + date % 100
+        try:
+            midnight = calendar.timegm((year, month, day, 0, 0, 0))
+        except ValueError:
+            continue
+        points.append((edge, midnight * 1000000 + utc_ms * 1000, drift))
+    points.sort()
+    if not points:
+        return None
+    edges = [p[0] for p in points]
+
+    def to_utc_us(ts):
+        i = bisect.bisect_right(edges, ts) - 1
+        if 0 <= i < len(points) - 1:
+            (e0, u0, _), (e1, u1, _) = points[i], points[i + 1]
+            return u0 + (ts - e0) * (u1 - u0) // (e1 - e0)
+        e0, u0, drift = points[max(i, 0)]
+        return u0 + ((ts - e0) * 1000000 * 1000000000) // (tick_hz * (1000000000 + drift))
+
+    return to_utc_us
+
+
+def fixed_point(value, digits):
+    """Exact decimal text for an integer scaled by 10**digits (no float rounding in track plots)."""
+    sign = "-" if value < 0 else ""
+    whole, frac = divmod(abs(value), 10**digits)
+    return f"{sign}{whole}.{frac:0{digits}d}"
+
+
+def format_gps_row(ts, lat, lon, alt, speed, course, fix_type, locked, sats):
+    """Time,Lat,Lon,Alt,Spd,Course,Fix,Locked,Sats with Lat/Lon in degrees and Spd in km/h, as map_gen.py reads"""
+    kph_centi = (speed * 36 + 50) // 100  # MM/S -> 0.01 KM/H
+    return ",".join(
+        [
+            str(ts),
+            fixed_point(lat, 7),
+            fixed_point(lon, 7),
+            fixed_point(alt, 3),
+            fixed_point(kph_centi, 2),
+            fixed_point(course, 2),
+            str(fix_type),
+            str(int(locked)),
+            str(sats),
+        ]
+    )
+
+
+def format_dr_row(ts, lat, lon, heading, speed):
+    """Time,Lat,Lon,Spd,Course for a dead-reckoned point, Spd in km/h like format_gps_row"""
+    kph_centi = (speed * 36 + 5) // 10  # CM/S -> 0.01 KM/H
+    return ",".join(
+        [str(ts), fixed_point(lat, 7), fixed_point(lon, 7), fixed_point(kph_centi, 2), fixed_point(heading, 2)]
+    )
+
+
+def format_prof_row(time, core_hz, probe, count, lo, hi, mean, first, hist):
+    """Time,Probe,Count,MinUs,MaxUs,MeanUs,Hist; Hist lists 'lowest cycles:count' per log2 bin, space separated"""
+
+    def us(cycles):
+        return fixed_point(cycles * 1000000000 // core_hz, 3)  # NS, SHOWN AS US
+
+    bins = " ".join(f"{1 << (first + i) if first + i else 0}:{c}" for i, c in enumerate(hist) if c)
+    return ",".join([str(time), probe, str(count), us(lo), us(hi), us(mean), bins])
+
+
+def format_crash(c):
+    """One summary block per CRASH record: what reset the board, and where it was"""
+
+    def name(table, i):
+        return table[i] if i < len(table) else str(i)
+
+    task = "none" if c["task"] == CRASH_NO_TASK else str(c["task"])
+    lines = [
+        f"previous run ended by a {name(RESET_CAUSES, c['cause'])} reset, fault: {name(CRASH_KINDS, c['kind'])}",
+    ]
+    if not c["held"]:
+        lines.append("  no context: backup SRAM did not survive (power was lost)")
+        return "\n".join(lines)
+    lines.append(
+        f"  at {c['uptime_ms']} ms, state {name(SYS_STATES, c['state'])}, scheduler task {task} (tasks.h TASK_* order)"
+    )
+    if c["kind"]:
+        lines.append(f"  pc 0x{c['pc']:08X}  lr 0x{c['lr']:08X}  sp 0x{c['sp']:08X}  xpsr 0x{c['xpsr']:08X}")
+        lines.append(f"  r0 0x{c['r0']:08X}  r1 0x{c['r1']:08X}  r2 0x{c['r2']:08X}  r3 0x{c['r3']:08X}  r12 0x{c['r12']:08X}")
+        lines.append(
+            f"  cfsr 0x{c['cfsr']:08X}  hfsr 0x{c['hfsr']:08X}  mmfar 0x{c['mmfar']:08X}  bfar 0x{c['bfar']:08X}"
+        )
+    lines.append(
+        f"  CAN ring {(c['can_head'] - c['can_tail']) & 0xFFFFFFFF} unread ({c['can_dropped']} dropped), "
+        f"priority {(c['prio_head'] - c['prio_tail']) & 0xFFFFFFFF} unread ({c['prio_dropped']} dropped), "
+        f"{c['staged']} SD bytes staged: lost with the reset"
+    )
+    return "\n".join(lines)
+
+
+def decode_file(
+    in_path,
+    out_path,
+    time_unit="ms",
+    id_stats=None,
+    imu_out_path=None,
+    gps_out_path=None,
+    utc=False,
+    dr_out_path=None,
+    prof_out_path=None,
+    crashes=None,
+):
+    """
+    time_unit 'ms' matches the legacy CSV Time column; 'us' keeps full timebase resolution.
+    id_stats, if given, is filled with {can_id: (logged, suppressed)}.
+    imu_out_path, if given, receives every IMU6 sample with gyro and temperature channels.
+    gps_out_path, if given, receives every GPS fix in a layout map_gen.py can plot.
+    dr_out_path, if given, receives the dead-reckoned track between fixes (Time,Lat,Lon,Spd,Course).
+    prof_out_path, if given, receives the firmware's periodic hot-path timing records.
+    crashes, if given, is filled with the CRASH records (normally at most one, at the start of the log).
+    utc=True writes every Time column as UTC since the Unix epoch (in time_unit), from the SYNC records.
+    """
+    blob = Path(in_path).read_bytes()
+    out_hz = 1000 if time_unit == "ms" else 1000000
+    tick_hz = read_tick_hz(blob)
+    to_utc_us = None
+    if utc:
+        syncs = []
+        for _ in iter_records(blob, syncs=syncs):
+            pass
+        to_utc_us = utc_mapper(syncs, tick_hz)
+        if to_utc_us is None:
+            raise BbxFormatError("no SYNC records with a date; cannot place this log in UTC")
+
+    def to_time(ts):
+        if to_utc_us is not None:
+            return to_utc_us(ts) * out_hz // 1000000
+        return ts * out_hz // tick_hz
+
+    logged = {}
+    skipped = {}
+    imu_samples = [] if imu_out_path else None
+    gps_fixes = [] if gps_out_path else None
+    dr_points = [] if dr_out_path else None
+    profs = [] if prof_out_path else None
+    rows = 0
+    with open(out_path, "w", newline="\n") as out:
+        for ts, can_id, dlc, data, imu in iter_records(
+            blob, skipped, imu_samples, gps_fixes, dr_points=dr_points, profs=profs, crashes=crashes
+        ):
+            out.write(format_csv_row(to_time(ts), can_id, dlc, data, imu) + "\n")
+            logged[can_id] = logged.get(can_id, 0) + 1
+            rows += 1
+    if imu_out_path:
+        with open(imu_out_path, "w", newline="\n") as out:
+            out.write("Time,ax,ay,az,gx,gy,gz,temp\n")
+            for ts, *channels in imu_samples:
+                out.write(",".join([str(to_time(ts))] + [str(v) for v in channels]) + "\n")
+    if gps_out_path:
+        with open(gps_out_path, "w", newline="\n") as out:
+            out.write("Time,Lat,Lon,Alt,Spd,Course,Fix,Locked,Sats\n")
+            for ts, *fields in gps_fixes:
+                out.write(format_gps_row(to_time(ts), *fields) + "\n")
+    if dr_out_path:
+        with open(dr_out_path, "w", newline="\n") as out:
+            out.write("Time,Lat,Lon,Spd,Course\n")
+            for ts, *fields in dr_points:
+                out.write(format_dr_row(to_time(ts), *fields) + "\n")
+    if prof_out_path:
+        with open(prof_out_path, "w", newline="\n") as out:
+            out.write("Time,Probe,Count,MinUs,MaxUs,MeanUs,Hist\n")
+            for ts, *fields in profs:
+                out.write(format_prof_row(to_time(ts), *fields) + "\n")
+    if id_stats is not None:
+        for can_id in sorted(set(logged) | set(skipped)):
+            if can_id != IMU_ONLY_ID:
+                id_stats[can_id] = (logged.get(can_id, 0), skipped.get(can_id, 0))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a .bbx binary log into the firmware CSV layout.")
+    parser.add_argument("bbx", help="Path to .bbx log")
+    parser.add_argument(
+        "--out",
+        "-o",
+        default=None,
+        help="Output CSV path (default: next to the input, .csv extension)",
+    )
+    parser.add_argument(
+        "--time-unit",
+        choices=("ms", "us"),
+        default="ms",
+        help="Time column unit (default ms, as the CSV firmware mode writes)",
+    )
+    parser.add_argument(
+        "--imu-out",
+        default=None,
+        help="Also write full-rate IMU samples (accel, gyro, temp) to this CSV",
+    )
+    parser.add_argument(
+        "--gps-out",
+        default=None,
+        help="Also write GPS fixes (Time,Lat,Lon,Alt,Spd,...) to this CSV for map_gen.py",
+    )
+    parser.add_argument(
+        "--dr-out",
+        default=None,
+        help="Also write the dead-reckoned track (20-100 Hz between GPS fixes) to this CSV for map_gen.py",
+    )
+    parser.add_argument(
+        "--prof-out",
+        default=None,
+        help="Also write the firmware's hot-path timings (one row per probe per 10 s interval) to this CSV",
+    )
+    parser.add_argument(
+        "--utc",
+        action="store_true",
+        help="Write Time as UTC since the Unix epoch, aligned by the GPS PPS sync records",
+    )
+    args = parser.parse_args()
+
+    src = Path(args.bbx)
+    if not src.is_file():
+        print(f"File not found: {src}")
+        sys.exit(1)
+    out_path = Path(args.out) if args.out else src.with_suffix(".csv")
+
+    id_stats = {}
+    crashes = []
+    try:
+        rows = decode_file(
+            src, out_path, time_unit=args.time_unit, id_stats=id_stats, imu_out_path=args.imu_out, gps_out_path=args.gps_out,
+            utc=args.utc,
+            dr_out_path=args.dr_out,
+            prof_out_path=args.prof_out,
+            crashes=crashes,
+        )
+    except BbxFormatError as e:
+        print(f"Error decoding {src}: {e}")
+        sys.exit(1)
+
+    print(f"Decoded {rows} rows: {src} -> {out_path}")
+    for crash in crashes:
+        print(format_crash(crash))
+    # Received = logged + suppressed, so bus rates survive the firmware's decimation
+    for can_id, (n_logged, n_skipped) in id_stats.items():
+        if n_skipped:
+            print(f"  0x{can_id:03X}: {n_logged} logged, {n_skipped} suppressed, {n_logged + n_skipped} received")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+import argparse
+import math
+import sys
+from pathlib import Path
+
+# Offline design of the IMU anti-alias FIR (BlackBox_V2/Core/Src/imu_filter.c).
+# The firmware only includes the q15 table written here, so its output does not
+# depend on the target's libm or FPU rounding. Run after changing the design:
+#   python3 tools/gen_imu_taps.py            (rewrite the header)
+#   python3 tools/gen_imu_taps.py --check    (exit 1 if the header is stale)
+
+TAPS = 48  # IMU_FILTER_TAPS, EVEN FOR SMLAD PAIRS
+DECIMATIONS = (2, 4, 5, 10)  # IMU_SAMPLE_RATE_HZ / IMU_LOG_RATE_HZ SETTINGS THAT HAVE A TABLE
+CUTOFF = 0.8  # FRACTION OF THE OUTPUT NYQUIST RATE
+Q15_ONE = 32767
+OUT = Path(__file__).resolve().parent.parent / "BlackBox_V2" / "Core" / "Inc" / "imu_filter_taps.h"
+
+
+def round_half_away(x):
+    return int(math.floor(abs(x) + 0.5)) * (1 if x >= 0 else -1)
+
+
+def design(decimation):
+    """Hamming-windowed sinc, quantised to q15 with the taps summing to exactly Q15_ONE (unity DC gain)"""
+    fc = CUTOFF * 0.5 / decimation  # CYCLES PER INPUT SAMPLE
+    center = (TAPS - 1) / 2.0
+    h = []
+    for k in range(TAPS):
+        t = k - center
+        sinc = 2.0 * fc if t == 0 else math.sin(2.0 * math.pi * fc * t) / (math.pi * t)
+        window = 0.54 - 0.46 * math.cos(2.0 * math.pi * k / (TAPS - 1))
+        h.append(sinc * window)
+    total = sum(h)
+    q = [round_half_away(v / total * Q15_ONE) for v in h]
+    q[TAPS // 2] += Q15_ONE - sum(q)
+    # THE DOT PRODUCT ACCUMULATES IN 32 BITS: FULL-SCALE INPUT TIMES sum|h| MUST FIT
+    if 32768 * sum(abs(c) for c in q) >= 1 << 31:
+        raise ValueError(f"decimation {decimation}: sum|h| too large for the int32 accumulator")
+    return q
+
+
+def render():
+    lines = [
+        "/*",
+        " * imu_filter_taps.h",
+        " *",
+        " * GENERATED by tools/gen_imu_taps.py, do not edit; change the design there",
+        " * and regenerate.",
+        " */",
+        "",
+        "#ifndef INC_IMU_FILTER_TAPS_H_",
+        "#define INC_IMU_FILTER_TAPS_H_",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"/* {TAPS}-tap Hamming-windowed sinc, cutoff at {int(CUTOFF * 100)}% of the output Nyquist rate, q15, taps sum to {Q15_ONE} */",
+        f"#if IMU_FILTER_TAPS != {TAPS}",
+        '#error "imu_filter_taps.h was generated for a different IMU_FILTER_TAPS"',
+        "#endif",
+        "",
+    ]
+    for i, d in enumerate(DECIMATIONS):
+        lines.append(f"#{'if' if i == 0 else 'elif'} IMU_FILTER_DECIMATION == {d}")
+        lines.append("static const int16_t imu_filter_coeffs[IMU_FILTER_TAPS] = {")
+        q = design(d)
+        for row in range(0, TAPS, 8):
+            lines.append("\t" + ", ".join(f"{c:6d}" for c in q[row : row + 8]) + ",")
+        lines.append("};")
+    lines += [
+        "#elif IMU_FILTER_DECIMATION > 1",
+        '#error "no tap table for this IMU_FILTER_DECIMATION; add it to DECIMATIONS in tools/gen_imu_taps.py"',
+        "#endif",
+        "",
+        "#endif /* INC_IMU_FILTER_TAPS_H_ */",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the IMU filter's q15 tap tables.")
+    parser.add_argument("--check", action="store_true", help="Compare with the checked-in header instead of writing it")
+    args = parser.parse_args()
+
+    text = render()
+    if args.check:
+        if not OUT.is_file() or OUT.read_text() != text:
+            print(f"{OUT} is stale; run tools/gen_imu_taps.py")
+            sys.exit(1)
+        print(f"{OUT} is up to date")
+        return
+    OUT.write_text(text)
+    print(f"Wrote {OUT}")
+
+
+if __name__ == "__main__":
+    main()
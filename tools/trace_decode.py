@@ -0,0 +1,159 @@
+import argparse
+import re
+import struct
+import sys
+from pathlib import Path
+
+# Trace stream decoder. The board sends a message id and raw 32-bit arguments
+# (BlackBox_V2/Core/Inc/trace.h); the format strings live only in trace_msgs.h,
+# which this tool reads so the two never drift apart.
+
+TRACE_SYNC = 0xA5
+TRACE_ID_TEXT = 0
+TRACE_TEXT_MAX = 200
+DEFAULT_MSGS = Path(__file__).resolve().parent.parent / "BlackBox_V2" / "Core" / "Inc" / "trace_msgs.h"
+
+_ENTRY = re.compile(r'X\(\s*(\w+)\s*,\s*TRACE_(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+# printf conversion: flags, width, precision, length modifier, conversion
+_CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diouxXc%])")
+
+
+class TraceFormatError(Exception):
+    pass
+
+
+def load_messages(path):
+    """Return {id: (name, level, format)} in table order; id 0 is free text."""
+    text = Path(path).read_text()
+    start = text.find("#define TRACE_MSGS(X)")
+    if start < 0:
+        raise TraceFormatError(f"no TRACE_MSGS table in {path}")
+    messages = {}
+    for i, (name, level, fmt) in enumerate(_ENTRY.findall(text[start:]), start=1):
+        fmt = fmt.encode().decode("unicode_escape")
+        messages[i] = (name, level, fmt)
+    return messages
+
+
+def format_message(fmt, args):
+    """Apply a C format to raw u32 arguments: %d/%i are read as signed, length modifiers are dropped."""
+    values = iter(args)
+    out = []
+    pos = 0
+    for m in _CONVERSION.finditer(fmt):
+        out.append(fmt[pos : m.start()])
+        pos = m.end()
+        spec, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        value = next(values, None)
+        if value is None:
+            out.append("<missing>")
+            continue
+        if conv in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            conv = "d"
+        elif conv == "u":
+            conv = "d"
+        out.append(f"%{spec}{conv}" % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def _take_entries(buf, final):
+    """Pop every complete entry off the front of buf; with final set, a partial tail is resynced past."""
+    while True:
+        start = buf.find(bytes([TRACE_SYNC]))
+        if start < 0:
+            buf.clear()
+            return
+        del buf[:start]
+        if len(buf) < 8:
+            return
+        length = buf[2]
+        total = 8 + length
+        if length > TRACE_TEXT_MAX or (buf[1] != TRACE_ID_TEXT and length % 4):
+            del buf[:1]  # NOT A LENGTH THE BOARD WRITES: FALSE SYNC
+            continue
+        if len(buf) < total:
+            if final:
+                del buf[:1]
+                continue
+            return
+        if (sum(buf[1 : total - 1]) & 0xFF) != buf[total - 1]:
+            del buf[:1]  # FALSE SYNC OR DAMAGED ENTRY, LOOK FOR THE NEXT ONE
+            continue
+        (ts,) = struct.unpack_from("<I", buf, 3)
+        yield ts, buf[1], bytes(buf[7 : total - 1])
+        del buf[:total]
+
+
+def iter_entries(stream):
+    """
+    Yield (timestamp_us, id, payload) from a byte iterator of trace entries.
+    Bytes before a sync or inside a bad entry are skipped, so decoding can start mid-stream.
+    """
+    buf = bytearray()
+    for chunk in stream:
+        buf += chunk
+        yield from _take_entries(buf, final=False)
+    yield from _take_entries(buf, final=True)
+
+
+def format_entry(messages, ts, msg_id, payload):
+    stamp = f"[{ts // 1000000:6d}.{ts % 1000000:06d}]"
+    if msg_id == TRACE_ID_TEXT:
+        return f"{stamp} TEXT  {payload.decode('ascii', 'replace').rstrip()}"
+    if msg_id not in messages:
+        return f"{stamp} ?     id {msg_id} not in trace_msgs.h: {payload.hex()}"
+    _name, level, fmt = messages[msg_id]
+    args = struct.unpack(f"<{len(payload) // 4}I", payload[: len(payload) // 4 * 4])
+    return f"{stamp} {level:<5} {format_message(fmt, args)}"
+
+
+def _read_file(path):
+    with open(path, "rb") as f:
+        while True:
+            chunk = f.read(4096)
+            if not chunk:
+                return
+            yield chunk
+
+
+def _read_serial(port, baud):
+    try:
+        import serial
+    except ImportError:
+        print("Reading a serial port needs pyserial (pip install pyserial)")
+        sys.exit(1)
+    with serial.Serial(port, baud, timeout=0.1) as ser:
+        while True:
+            chunk = ser.read(4096)
+            if chunk:
+                yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Format the board's binary trace stream (USART2).")
+    parser.add_argument("source", help="Serial port (COM5, /dev/ttyACM0) or a captured binary file")
+    parser.add_argument("--baud", type=int, default=115200, help="Serial baud rate (default 115200)")
+    parser.add_argument("--msgs", default=str(DEFAULT_MSGS), help="trace_msgs.h the firmware was built with")
+    args = parser.parse_args()
+
+    try:
+        messages = load_messages(args.msgs)
+    except (OSError, TraceFormatError) as e:
+        print(f"Cannot load message table: {e}")
+        sys.exit(1)
+
+    source = _read_file(args.source) if Path(args.source).is_file() else _read_serial(args.source, args.baud)
+    try:
+        for ts, msg_id, payload in iter_entries(source):
+            print(format_entry(messages, ts, msg_id, payload), flush=True)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()